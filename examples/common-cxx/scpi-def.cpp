@@ -417,6 +417,7 @@ scpi_interface_t scpi_interface = {
     /*.control = */ SCPI_Control,
     /*.flush = */ SCPI_Flush,
     /*.reset = */ SCPI_Reset,
+    /*.writev = */ NULL,
 };
 
 char scpi_input_buffer[SCPI_INPUT_BUFFER_LENGTH];
@@ -420,6 +420,7 @@ scpi_interface_t scpi_interface = {
 };
 
 char scpi_input_buffer[SCPI_INPUT_BUFFER_LENGTH];
+char scpi_output_buffer[SCPI_OUTPUT_BUFFER_LENGTH];
 scpi_error_t scpi_error_queue_data[SCPI_ERROR_QUEUE_SIZE];
 
 scpi_t scpi_context;
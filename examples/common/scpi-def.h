@@ -35,6 +35,7 @@ extern "C" {
 #include "scpi/scpi.h"
 
 #define SCPI_INPUT_BUFFER_LENGTH 256
+#define SCPI_OUTPUT_BUFFER_LENGTH 256
 #define SCPI_ERROR_QUEUE_SIZE 17
 #define SCPI_IDN1 "MANUFACTURE"
 #define SCPI_IDN2 "INSTR2013"
@@ -44,6 +45,7 @@ extern "C" {
 extern const scpi_command_t scpi_commands[];
 extern scpi_interface_t scpi_interface;
 extern char scpi_input_buffer[];
+extern char scpi_output_buffer[];
 extern scpi_error_t scpi_error_queue_data[];
 extern scpi_t scpi_context;
 
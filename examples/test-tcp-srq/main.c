@@ -59,6 +59,7 @@ typedef struct {
     int control_io_listen;
     FILE * fio;
     fd_set fds;
+    fd_set wfds;
 } user_data_t;
 
 size_t SCPI_Write(scpi_t * context, const char * data, size_t len) {
@@ -178,9 +179,15 @@ static int waitServer(user_data_t * user_data) {
     int rc;
 
     FD_ZERO(&user_data->fds);
+    FD_ZERO(&user_data->wfds);
 
     if (user_data->io >= 0) {
-        FD_SET(user_data->io, &user_data->fds);
+        /* no input is read until pending response is written */
+        if (SCPI_OutputPending(&scpi_context)) {
+            FD_SET(user_data->io, &user_data->wfds);
+        } else {
+            FD_SET(user_data->io, &user_data->fds);
+        }
     }
 
     if (user_data->io_listen >= 0) {
@@ -198,7 +205,7 @@ static int waitServer(user_data_t * user_data) {
     timeout.tv_sec = 5;
     timeout.tv_usec = 0;
 
-    rc = select(FD_SETSIZE, &user_data->fds, NULL, NULL, &timeout);
+    rc = select(FD_SETSIZE, &user_data->fds, &user_data->wfds, NULL, &timeout);
 
     return rc;
 }
@@ -227,6 +234,8 @@ static void closeIo(user_data_t * user_data) {
     fclose(user_data->fio);
     user_data->fio = NULL;
     user_data->io = -1;
+    /* drop response of closed connection */
+    SCPI_InitOutputBuffer(&scpi_context, scpi_output_buffer, SCPI_OUTPUT_BUFFER_LENGTH);
 }
 
 static void closeSrqIo(user_data_t * user_data) {
@@ -284,6 +293,7 @@ int main(int argc, char** argv) {
         /*.control_io =*/ -1,
         /*.fio =*/ NULL,
         /*.fds =*/ 0,
+        /*.wfds =*/ 0,
     };
 #else
     user_data_t user_data = {
@@ -303,6 +313,7 @@ int main(int argc, char** argv) {
             SCPI_IDN1, SCPI_IDN2, SCPI_IDN3, SCPI_IDN4,
             scpi_input_buffer, SCPI_INPUT_BUFFER_LENGTH,
             scpi_error_queue_data, SCPI_ERROR_QUEUE_SIZE);
+    SCPI_InitOutputBuffer(&scpi_context, scpi_output_buffer, SCPI_OUTPUT_BUFFER_LENGTH);
     scpi_context.user_context = &user_data;
 
     user_data.io_listen = createServer(5025);
@@ -328,6 +339,10 @@ int main(int argc, char** argv) {
             processSrqIoListen(&user_data);
         }
 
+        if ((user_data.io >= 0) && FD_ISSET(user_data.io, &user_data.wfds)) {
+            SCPI_OutputReady(&scpi_context);
+        }
+
         if ((user_data.io >= 0) && FD_ISSET(user_data.io, &user_data.fds)) {
             processIo(&user_data);
         }
@@ -55,9 +55,12 @@ size_t SCPI_Write(scpi_t * context, const char * data, size_t len) {
         int fd = *(int *) (context->user_context);
 
         int state = 1;
+        ssize_t rc;
         setsockopt(fd, IPPROTO_TCP, TCP_CORK, &state, sizeof(state));
 
-        return write(fd, data, len);
+        /* data not accepted by non blocking socket are queued by library */
+        rc = write(fd, data, len);
+        return (rc < 0) ? 0 : (size_t) rc;
     }
     return 0;
 }
@@ -158,7 +161,7 @@ static int createServer(int port) {
     return fd;
 }
 
-static int waitServer(int fd) {
+static int waitServer(int fd, scpi_bool_t output_pending) {
     fd_set fds;
     struct timeval timeout;
     int rc;
@@ -171,7 +174,12 @@ static int waitServer(int fd) {
     timeout.tv_sec = 5;
     timeout.tv_usec = 0;
 
-    rc = select(max_fd + 1, &fds, NULL, NULL, &timeout);
+    /* no input is read until pending response is written */
+    if (output_pending) {
+        rc = select(max_fd + 1, NULL, &fds, NULL, &timeout);
+    } else {
+        rc = select(max_fd + 1, &fds, NULL, NULL, &timeout);
+    }
 
     return rc;
 }
@@ -197,6 +205,7 @@ int main(int argc, char** argv) {
             SCPI_IDN1, SCPI_IDN2, SCPI_IDN3, SCPI_IDN4,
             scpi_input_buffer, SCPI_INPUT_BUFFER_LENGTH,
             scpi_error_queue_data, SCPI_ERROR_QUEUE_SIZE);
+    SCPI_InitOutputBuffer(&scpi_context, scpi_output_buffer, SCPI_OUTPUT_BUFFER_LENGTH);
 
     listenfd = createServer(5025);
 
@@ -217,7 +226,19 @@ int main(int argc, char** argv) {
         scpi_context.user_context = &clifd;
 
         while (1) {
-            rc = waitServer(clifd);
+            if (SCPI_OutputPending(&scpi_context)) {
+                rc = waitServer(clifd, TRUE);
+                if (rc < 0) { /* failed */
+                    perror("  select() failed");
+                    break;
+                }
+                if (rc > 0) { /* socket accepts more data */
+                    SCPI_OutputReady(&scpi_context);
+                }
+                continue;
+            }
+
+            rc = waitServer(clifd, FALSE);
             if (rc < 0) { /* failed */
                 perror("  recv() failed");
                 break;
@@ -241,6 +262,9 @@ int main(int argc, char** argv) {
             }
         }
 
+        /* drop response of closed connection */
+        scpi_context.user_context = NULL;
+        SCPI_InitOutputBuffer(&scpi_context, scpi_output_buffer, SCPI_OUTPUT_BUFFER_LENGTH);
         close(clifd);
     }
 
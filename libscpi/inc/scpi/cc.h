@@ -114,6 +114,28 @@ extern "C" {
     #define HAVE_STDBOOL 1
 #endif
 
+/* Vector instructions enabled by compiler options */
+#if defined(__AVX2__)
+    #define HAVE_AVX2 1
+#endif
+
+#if defined(__SSSE3__) || defined(__AVX2__)
+    #define HAVE_SSSE3 1
+#endif
+
+#if defined(__SSE2__) || defined(__SSSE3__) || defined(__AVX2__)
+    #define HAVE_SSE2 1
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define HAVE_NEON 1
+#endif
+
+/* Atomic builtins of GCC and Clang */
+#if defined(__GNUC__) && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 7)))
+    #define HAVE_ATOMIC_BUILTINS 1
+#endif
+
 /* Compiler specific */
 /* RealView/Keil ARM Compiler, e.g. Cortex-M CPUs */
 #if defined(__CC_ARM)
@@ -200,6 +222,26 @@ extern "C" {
 #define HAVE_STRTOF             0
 #endif
 
+#ifndef HAVE_SSE2
+#define HAVE_SSE2               0
+#endif
+
+#ifndef HAVE_SSSE3
+#define HAVE_SSSE3              0
+#endif
+
+#ifndef HAVE_AVX2
+#define HAVE_AVX2               0
+#endif
+
+#ifndef HAVE_NEON
+#define HAVE_NEON               0
+#endif
+
+#ifndef HAVE_ATOMIC_BUILTINS
+#define HAVE_ATOMIC_BUILTINS    0
+#endif
+
 #ifndef  HAVE_DTOSTRE
 #define  HAVE_DTOSTRE           0
 #endif
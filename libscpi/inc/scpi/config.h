@@ -87,6 +87,49 @@ extern "C" {
 #define USE_FULL_ERROR_LIST SYSTEM_TYPE
 #endif
 
+/**
+ * Error queue accepts errors posted by SCPI_ErrorPost from other threads and
+ * interrupt handlers without locking. Compiler atomic builtins are needed.
+ * 0 = Errors are pushed only from the parser thread
+ * 1 = Lock-free multi-producer single-consumer error queue
+ */
+#ifndef USE_LOCKFREE_ERROR_QUEUE
+#define USE_LOCKFREE_ERROR_QUEUE 0
+#endif
+
+/**
+ * Register bits can be posted by SCPI_RegPostBits and SCPI_RegPostClearBits
+ * from other threads without locking. Event propagation and SRQ are done
+ * once per SCPI_RegSync in parser thread. Compiler atomic builtins are needed.
+ * 0 = Registers are changed only from the parser thread
+ * 1 = Lock-free posting of register bits
+ */
+#ifndef USE_ATOMIC_REGISTERS
+#define USE_ATOMIC_REGISTERS 0
+#endif
+
+/**
+ * Register changes between SCPI_RegBegin and SCPI_RegCommit are evaluated
+ * together and SRQ is signalled at most once. Previous values of all
+ * registers are kept in the context. It is needed by USE_ATOMIC_REGISTERS.
+ * 0 = Every register change is evaluated immediately
+ * 1 = SCPI_RegBegin and SCPI_RegCommit are available
+ */
+#ifndef USE_REGISTER_TRANSACTIONS
+#define USE_REGISTER_TRANSACTIONS USE_ATOMIC_REGISTERS
+#endif
+
+/**
+ * Condition registers are sampled from callbacks set by
+ * SCPI_RegConditionSource when they, their event registers or status byte
+ * are read.
+ * 0 = Condition registers are changed only by SCPI_RegSet
+ * 1 = SCPI_RegConditionSource is available
+ */
+#ifndef USE_REGISTER_CONDITION_SOURCE
+#define USE_REGISTER_CONDITION_SOURCE 0
+#endif
+
 /**
  * Enable also LIST_OF_USER_ERRORS to be included
  * 0 = Use only library defined errors
@@ -114,14 +157,118 @@ extern "C" {
 #define USE_COMMAND_TAGS 1
 #endif
 
+/**
+ * Use command lookup tables generated by libscpi/tools/cmdhash.c
+ * 0 = Commands are searched in the command list
+ * 1 = Application links scpi_precompiled_commands generated from its command list
+ */
+#ifndef USE_PRECOMPILED_COMMANDS
+#define USE_PRECOMPILED_COMMANDS 0
+#endif
+
+/**
+ * Number of parameter tokens remembered from detection of program message
+ * unit. SCPI_Parameter returns them without lexing the input again, other
+ * parameters are lexed on demand. Tokens are stored on the stack of
+ * SCPI_Parse, not in the context.
+ * 0 = Parameters are always lexed by SCPI_Parameter
+ */
+#ifndef SCPI_PARAMETER_TOKENS_MAX
+#define SCPI_PARAMETER_TOKENS_MAX 16
+#endif
+
+/**
+ * Session owns its instrument definition
+ * 0 = Sessions are initialized by SCPI_InitSession with shared definition,
+ *     SCPI_Init, SCPI_CompileCommands and SCPI_CompileUnits are not available
+ * 1 = SCPI_Init stores the definition in the context, deprecated cmdlist,
+ *     units and idn fields of the context are still available
+ */
+#ifndef USE_SESSION_DEFINITION
+#define USE_SESSION_DEFINITION 1
+#endif
+
+/**
+ * Maximal number of options of choice list compiled by SCPI_CompileChoices,
+ * it must be a power of two. Options are stored as uint8_t, so the biggest
+ * value is 128. Longer lists are searched linearly.
+ */
+#ifndef SCPI_CHOICE_INDEX_MAX
+#define SCPI_CHOICE_INDEX_MAX 32
+#endif
+
+#if (SCPI_CHOICE_INDEX_MAX < 1) || (SCPI_CHOICE_INDEX_MAX > 128) || (SCPI_CHOICE_INDEX_MAX & (SCPI_CHOICE_INDEX_MAX - 1))
+#error "SCPI_CHOICE_INDEX_MAX must be a power of two not bigger than 128"
+#endif
+
+/**
+ * Number of slots of unit index built by SCPI_CompileUnits. It must be
+ * a power of two bigger than number of unit definitions.
+ */
+#ifndef SCPI_UNITS_INDEX_SIZE
+#define SCPI_UNITS_INDEX_SIZE 256
+#endif
+
+/**
+ * Commands with block_sink receive arbitrary block data directly from
+ * SCPI_Input, so the block does not have to fit in the input buffer. Only
+ * the first program message unit is streamed, so the data are received
+ * before the command is executed, but never before other commands.
+ * Queries can leave data of arbitrary block response to a producer which
+ * is pulled by SCPI_OutputReady.
+ * It adds block_sink to every command, so it is disabled by default
+ */
+#ifndef USE_BLOCK_STREAMING
+#define USE_BLOCK_STREAMING 0
+#endif
+
 #ifndef USE_DEPRECATED_FUNCTIONS
 #define USE_DEPRECATED_FUNCTIONS 1
 #endif
 
+/* Number of repeated write calls, with flush in between, when the output
+ * buffer is full and interface accepts nothing. Rest of the response is
+ * discarded after them. */
+#ifndef SCPI_OUTPUT_WRITE_RETRIES
+#define SCPI_OUTPUT_WRITE_RETRIES 4
+#endif
+
+/* Size of buffer on stack used to swap bytes of binary array results */
+#ifndef SCPI_SWAP_BUFFER_LENGTH
+#define SCPI_SWAP_BUFFER_LENGTH 256
+#endif
+
 #ifndef USE_CUSTOM_DTOSTRE
 #define USE_CUSTOM_DTOSTRE 0
 #endif
 
+/**
+ * Format float and double results by built-in Grisu3 conversion as the
+ * shortest string which converts back to the same value
+ */
+#ifndef USE_FAST_DTOA
+#define USE_FAST_DTOA 0
+#endif
+
+/**
+ * Parse decimal numbers by built-in correctly rounded conversion instead
+ * of locale dependent strtod and strtof
+ */
+#ifndef USE_FAST_STRTOD
+#define USE_FAST_STRTOD 1
+#endif
+
+/**
+ * Lexer computes value of decimal numbers while scanning them and stores it
+ * in the token, so parameters are converted without parsing the text again.
+ * It makes every token and scpi_t bigger, so it is enabled only on full
+ * blown systems by default. Integer parameters are converted with the same
+ * results as by strtol in both cases.
+ */
+#ifndef USE_NUMERIC_TOKEN_VALUE
+#define USE_NUMERIC_TOKEN_VALUE SYSTEM_TYPE
+#endif
+
 #ifndef USE_UNITS_IMPERIAL
 #define USE_UNITS_IMPERIAL 0
 #endif
@@ -194,7 +341,9 @@ extern "C" {
 #define SCPIDEFINE_strncasecmp(s1, s2, l) OUR_strncasecmp((s1), (s2), (l))
 #endif
 
-#if HAVE_DTOSTRE
+#if USE_FAST_DTOA
+#define SCPIDEFINE_floatToStr(v, s, l) dtoaFloat((v), (s), (l), 0)
+#elif HAVE_DTOSTRE
 #define SCPIDEFINE_floatToStr(v, s, l) dtostre((double)(v), (s), 6, DTOSTR_PLUS_SIGN | DTOSTR_ALWAYS_SIGN | DTOSTR_UPPERCASE)
 #elif USE_CUSTOM_DTOSTRE
 #define SCPIDEFINE_floatToStr(v, s, l) SCPI_dtostre((v), (s), (l), 6, 0)
@@ -204,7 +353,9 @@ extern "C" {
 #define SCPIDEFINE_floatToStr(v, s, l) SCPI_dtostre((v), (s), (l), 6, 0)
 #endif
 
-#if HAVE_DTOSTRE
+#if USE_FAST_DTOA
+#define SCPIDEFINE_doubleToStr(v, s, l) dtoaDouble((v), (s), (l), 0)
+#elif HAVE_DTOSTRE
 #define SCPIDEFINE_doubleToStr(v, s, l) dtostre((v), (s), 15, DTOSTR_PLUS_SIGN | DTOSTR_ALWAYS_SIGN | DTOSTR_UPPERCASE)
 #elif USE_CUSTOM_DTOSTRE
 #define SCPIDEFINE_doubleToStr(v, s, l) SCPI_dtostre((v), (s), (l), 15, 0)
@@ -238,6 +389,22 @@ extern "C" {
   #define SCPIDEFINE_free(h, s, r)
 #endif
 
+#if HAVE_ATOMIC_BUILTINS
+  #define SCPIDEFINE_atomic_load(p)                     __atomic_load_n((p), __ATOMIC_ACQUIRE)
+  #define SCPIDEFINE_atomic_store(p, v)                 __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+  #define SCPIDEFINE_atomic_cas(p, e, v)                __atomic_compare_exchange_n((p), (e), (v), 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+  #define SCPIDEFINE_atomic_or(p, v)                    __atomic_fetch_or((p), (v), __ATOMIC_ACQ_REL)
+  #define SCPIDEFINE_atomic_exchange(p, v)              __atomic_exchange_n((p), (v), __ATOMIC_ACQ_REL)
+#elif USE_LOCKFREE_ERROR_QUEUE
+  #error USE_LOCKFREE_ERROR_QUEUE needs atomic operations
+#elif USE_ATOMIC_REGISTERS
+  #error USE_ATOMIC_REGISTERS needs atomic operations
+#endif
+
+#if USE_ATOMIC_REGISTERS && !USE_REGISTER_TRANSACTIONS
+  #error USE_ATOMIC_REGISTERS needs USE_REGISTER_TRANSACTIONS
+#endif
+
 #if HAVE_SIGNBIT
   #define SCPIDEFINE_signbit(n)                         signbit(n)
 #else
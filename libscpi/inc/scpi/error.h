@@ -50,6 +50,10 @@ extern "C" {
     scpi_bool_t SCPI_ErrorPop(scpi_t * context, scpi_error_t * error);
     void SCPI_ErrorPushEx(scpi_t * context, int16_t err, char * info, size_t info_len);
     void SCPI_ErrorPush(scpi_t * context, int16_t err);
+#if USE_LOCKFREE_ERROR_QUEUE
+    void SCPI_ErrorPost(scpi_t * context, int16_t err);
+    void SCPI_ErrorSync(scpi_t * context);
+#endif
     int32_t SCPI_ErrorCount(scpi_t * context);
     const char * SCPI_ErrorTranslate(int16_t err);
 
@@ -174,10 +178,10 @@ extern "C" {
     X(SCPI_ERROR_INPUT_BUFFER_OVERRUN,          -363, "Input buffer overrun")                         \
     XE(SCPI_ERROR_TIME_OUT,                     -365, "Time out error")                               \
     XE(SCPI_ERROR_QUERY_ERROR,                  -400, "Query error")                                  \
-    XE(SCPI_ERROR_QUERY_INTERRUPTED,            -410, "Query INTERRUPTED")                            \
+    X(SCPI_ERROR_QUERY_INTERRUPTED,             -410, "Query INTERRUPTED")                            \
     XE(SCPI_ERROR_QUERY_UNTERMINATED,           -420, "Query UNTERMINATED")                           \
-    XE(SCPI_ERROR_QUERY_DEADLOCKED,             -430, "Query DEADLOCKED")                             \
-    XE(SCPI_ERROR_QUERY_UNTERM_INDEF_RESP,      -440, "Query UNTERMINATED after indefinite response") \
+    X(SCPI_ERROR_QUERY_DEADLOCKED,              -430, "Query DEADLOCKED")                             \
+    X(SCPI_ERROR_QUERY_UNTERM_INDEF_RESP,       -440, "Query UNTERMINATED after indefinite response") \
     XE(SCPI_ERROR_POWER_ON,                     -500, "Power on")                                     \
     XE(SCPI_ERROR_USER_REQUEST,                 -600, "User request")                                 \
     XE(SCPI_ERROR_REQUEST_CONTROL,              -700, "Request control")                              \
@@ -83,6 +83,18 @@ extern "C" {
     void SCPI_RegSet(scpi_t * context, scpi_reg_name_t name, scpi_reg_val_t val);
     void SCPI_RegSetBits(scpi_t * context, scpi_reg_name_t name, scpi_reg_val_t bits);
     void SCPI_RegClearBits(scpi_t * context, scpi_reg_name_t name, scpi_reg_val_t bits);
+#if USE_REGISTER_CONDITION_SOURCE
+    void SCPI_RegConditionSource(scpi_t * context, scpi_reg_group_t group, scpi_reg_condition_t source);
+#endif
+#if USE_REGISTER_TRANSACTIONS
+    void SCPI_RegBegin(scpi_t * context);
+    void SCPI_RegCommit(scpi_t * context);
+#endif
+#if USE_ATOMIC_REGISTERS
+    void SCPI_RegPostBits(scpi_t * context, scpi_reg_name_t name, scpi_reg_val_t bits);
+    void SCPI_RegPostClearBits(scpi_t * context, scpi_reg_name_t name, scpi_reg_val_t bits);
+    void SCPI_RegSync(scpi_t * context);
+#endif
 
     void SCPI_EventClear(scpi_t * context);
 
@@ -44,6 +44,7 @@
 #ifdef __cplusplus
 extern "C" {
 #endif
+#if USE_SESSION_DEFINITION
     void SCPI_Init(scpi_t * context,
             const scpi_command_t * commands,
             scpi_interface_t * interface,
@@ -51,11 +52,32 @@ extern "C" {
             const char * idn1, const char * idn2, const char * idn3, const char * idn4,
             char * input_buffer, size_t input_buffer_length,
             scpi_error_t * error_queue_data, int16_t error_queue_size);
+#endif
+    void SCPI_DefinitionInit(scpi_definition_t * definition,
+            const scpi_command_t * commands,
+            const scpi_unit_def_t * units,
+            const char * idn1, const char * idn2, const char * idn3, const char * idn4);
+    void SCPI_InitSession(scpi_t * context,
+            const scpi_definition_t * definition,
+            scpi_interface_t * interface,
+            char * input_buffer, size_t input_buffer_length,
+            scpi_error_t * error_queue_data, int16_t error_queue_size);
 #if USE_DEVICE_DEPENDENT_ERROR_INFORMATION && !USE_MEMORY_ALLOCATION_FREE
     void SCPI_InitHeap(scpi_t * context, char * error_info_heap, size_t error_info_heap_length);
 #endif
+    void SCPI_InitOutputBuffer(scpi_t * context, char * output_buffer, size_t output_buffer_length);
+    scpi_bool_t SCPI_OutputReady(scpi_t * context);
+    scpi_bool_t SCPI_OutputPending(scpi_t * context);
+#if USE_SESSION_DEFINITION
+    size_t SCPI_CompileCommands(scpi_t * context, scpi_command_node_t * nodes, size_t nodes_len);
+#endif
+    size_t SCPI_DefinitionCompileCommands(scpi_definition_t * definition, scpi_command_node_t * nodes, size_t nodes_len);
+#if USE_PRECOMPILED_COMMANDS
+    extern const scpi_precompiled_commands_t scpi_precompiled_commands;
+#endif
 
     scpi_bool_t SCPI_Input(scpi_t * context, const char * data, int len);
+    scpi_bool_t SCPI_InputInPlace(scpi_t * context, char * data, size_t len, size_t * consumed);
     scpi_bool_t SCPI_Parse(scpi_t * context, char * data, int len);
 
     size_t SCPI_ResultCharacters(scpi_t * context, const char * data, size_t len);
@@ -74,11 +96,15 @@ extern "C" {
     size_t SCPI_ResultInt64(scpi_t * context, int64_t val);
     size_t SCPI_ResultFloat(scpi_t * context, float val);
     size_t SCPI_ResultDouble(scpi_t * context, double val);
+    void SCPI_SetResultPrecision(scpi_t * context, int precision);
     size_t SCPI_ResultText(scpi_t * context, const char * data);
     size_t SCPI_ResultError(scpi_t * context, scpi_error_t * error);
     size_t SCPI_ResultArbitraryBlock(scpi_t * context, const void * data, size_t len);
     size_t SCPI_ResultArbitraryBlockHeader(scpi_t * context, size_t len);
     size_t SCPI_ResultArbitraryBlockData(scpi_t * context, const void * data, size_t len);
+#if USE_BLOCK_STREAMING
+    size_t SCPI_ResultArbitraryBlockProducer(scpi_t * context, size_t len, scpi_block_producer_t producer);
+#endif
     size_t SCPI_ResultBool(scpi_t * context, scpi_bool_t val);
 
     size_t SCPI_ResultArrayInt8(scpi_t * context, const int8_t * array, size_t count, scpi_array_format_t format);
@@ -104,6 +130,9 @@ extern "C" {
     scpi_bool_t SCPI_ParamToDouble(scpi_t * context, scpi_parameter_t * parameter, double * value);
     scpi_bool_t SCPI_ParamToChoice(scpi_t * context, scpi_parameter_t * parameter, const scpi_choice_def_t * options, int32_t * value);
     scpi_bool_t SCPI_ChoiceToName(const scpi_choice_def_t * options, int32_t tag, const char ** text);
+    size_t SCPI_CompileChoices(scpi_choice_index_t * index, const scpi_choice_def_t * options);
+    scpi_bool_t SCPI_ParamToChoiceIndex(scpi_t * context, scpi_parameter_t * parameter, const scpi_choice_index_t * index, int32_t * value);
+    scpi_bool_t SCPI_ChoiceIndexToName(const scpi_choice_index_t * index, int32_t tag, const char ** text);
 
     scpi_bool_t SCPI_ParamInt32(scpi_t * context, int32_t * value, scpi_bool_t mandatory);
     scpi_bool_t SCPI_ParamUInt32(scpi_t * context, uint32_t * value, scpi_bool_t mandatory);
@@ -118,6 +147,7 @@ extern "C" {
     extern const scpi_choice_def_t scpi_bool_def[];
     scpi_bool_t SCPI_ParamBool(scpi_t * context, scpi_bool_t * value, scpi_bool_t mandatory);
     scpi_bool_t SCPI_ParamChoice(scpi_t * context, const scpi_choice_def_t * options, int32_t * value, scpi_bool_t mandatory);
+    scpi_bool_t SCPI_ParamChoiceIndex(scpi_t * context, const scpi_choice_index_t * index, int32_t * value, scpi_bool_t mandatory);
 
     scpi_bool_t SCPI_ParamArrayInt32(scpi_t * context, int32_t *data, size_t i_count, size_t *o_count, scpi_array_format_t format, scpi_bool_t mandatory);
     scpi_bool_t SCPI_ParamArrayUInt32(scpi_t * context, uint32_t *data, size_t i_count, size_t *o_count, scpi_array_format_t format, scpi_bool_t mandatory);
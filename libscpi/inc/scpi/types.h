@@ -171,8 +171,12 @@ extern "C" {
 
     typedef struct _scpi_command_t scpi_command_t;
 
-#if USE_COMMAND_TAGS
+#if USE_COMMAND_TAGS && USE_BLOCK_STREAMING
+	#define SCPI_CMD_LIST_END       {NULL, NULL, 0, NULL}
+#elif USE_COMMAND_TAGS
 	#define SCPI_CMD_LIST_END       {NULL, NULL, 0}
+#elif USE_BLOCK_STREAMING
+	#define SCPI_CMD_LIST_END       {NULL, NULL, NULL}
 #else
 	#define SCPI_CMD_LIST_END       {NULL, NULL}
 #endif
@@ -196,8 +200,16 @@ extern "C" {
     };
     typedef struct _scpi_const_buffer_t scpi_const_buffer_t;
 
+    struct _scpi_iovec_t {
+        const char * data;
+        size_t len;
+    };
+    typedef struct _scpi_iovec_t scpi_iovec_t;
+
     typedef size_t(*scpi_write_t)(scpi_t * context, const char * data, size_t len);
+    typedef size_t(*scpi_write_vector_t)(scpi_t * context, const scpi_iovec_t * iov, size_t iovcnt);
     typedef scpi_result_t(*scpi_write_control_t)(scpi_t * context, scpi_ctrl_name_t ctrl, scpi_reg_val_t val);
+    typedef scpi_reg_val_t(*scpi_reg_condition_t)(scpi_t * context, scpi_reg_group_t group);
     typedef int (*scpi_error_callback_t)(scpi_t * context, int_fast16_t error);
 
     /* scpi lexer */
@@ -232,10 +244,24 @@ extern "C" {
     };
     typedef enum _scpi_token_type_t scpi_token_type_t;
 
+    /* Value of decimal numeric program data found by lexer, mantissa * 10^exponent */
+    struct _scpi_decimal_t {
+        uint64_t mantissa;
+        int32_t exponent;
+        int suffix; /* offset of suffix from start of the token */
+        uint8_t negative;
+        uint8_t truncated; /* more than 19 significant digits */
+        uint8_t integer; /* no decimal point and exponent */
+    };
+    typedef struct _scpi_decimal_t scpi_decimal_t;
+
     struct _scpi_token_t {
         scpi_token_type_t type;
         char * ptr;
         int len;
+#if USE_NUMERIC_TOKEN_VALUE
+        scpi_decimal_t decimal;
+#endif
     };
     typedef struct _scpi_token_t scpi_token_t;
 
@@ -254,15 +280,73 @@ extern "C" {
     };
     typedef enum _message_termination_t message_termination_t;
 
+    /* state of input scanner searching for end of program message */
+    enum _scpi_input_state_t {
+        SCPI_INPUT_STATE_UNIT,
+        SCPI_INPUT_STATE_HEADER,
+        SCPI_INPUT_STATE_DATA_HEADER,
+        SCPI_INPUT_STATE_PARAMETER,
+        SCPI_INPUT_STATE_DATA,
+        SCPI_INPUT_STATE_STRING,
+        SCPI_INPUT_STATE_STRING_QUOTE,
+        SCPI_INPUT_STATE_BLOCK,
+        SCPI_INPUT_STATE_BLOCK_LENGTH,
+        SCPI_INPUT_STATE_BLOCK_DATA,
+        SCPI_INPUT_STATE_BLOCK_STREAM,
+    };
+    typedef enum _scpi_input_state_t scpi_input_state_t;
+
+    struct _scpi_parameter_token_t {
+        scpi_token_t token;
+        char * end;
+    };
+    typedef struct _scpi_parameter_token_t scpi_parameter_token_t;
+
     struct _scpi_parser_state_t {
         scpi_token_t programHeader;
         scpi_token_t programData;
         int numberOfParameters;
         message_termination_t termination;
+#if SCPI_PARAMETER_TOKENS_MAX > 0
+        /* parameters of the last detected program message unit, they are
+         * stored by SCPI_Parse and set only while its command is processed */
+        const scpi_parameter_token_t * parameters;
+#endif
+        /* SCPI_Input scanner, continues where previous call stopped */
+        scpi_input_state_t input_state;
+        size_t input_start;
+        size_t input_pos;
+        size_t input_remaining;
+        int input_digits;
+        char input_quote;
+#if USE_BLOCK_STREAMING
+        /* command of the first program message unit and its block */
+        const scpi_command_t * input_cmd;
+        int input_units;
+        size_t input_header;
+        size_t input_block;
+        size_t input_total;
+        /* position of block rejected by block_sink in the message or 0 */
+        size_t input_failed;
+#endif
     };
     typedef struct _scpi_parser_state_t scpi_parser_state_t;
 
     typedef scpi_result_t(*scpi_command_callback_t)(scpi_t *);
+    /*
+     * Receiver of arbitrary block of the first program message unit. It gets
+     * len bytes at offset of block of total length as they arrive, callback
+     * of the command follows with empty block.
+     */
+    typedef scpi_result_t(*scpi_block_sink_t)(scpi_t * context, size_t total, size_t offset, const char * data, size_t len);
+    /*
+     * Producer of arbitrary block data fills buffer with at most max bytes
+     * and returns their count. Zero means no data are available now, the
+     * rest of the block is pulled by next SCPI_OutputReady. Length of the
+     * block is already sent, so producer which can not get the data must
+     * still deliver the rest of the block, e.g. zeros, and push an error.
+     */
+    typedef size_t(*scpi_block_producer_t)(scpi_t * context, char * buffer, size_t max);
 
     struct _scpi_error_info_heap_t {
         size_t wr;
@@ -282,9 +366,15 @@ extern "C" {
     typedef struct _scpi_error_t scpi_error_t;
 
     struct _scpi_fifo_t {
+#if USE_LOCKFREE_ERROR_QUEUE
+        /* free running positions, they wrap at the biggest multiple of size */
+        volatile uint32_t wr;
+        volatile uint32_t rd;
+#else
         int16_t wr;
         int16_t rd;
         int16_t count;
+#endif
         int16_t size;
         scpi_error_t * data;
     };
@@ -357,6 +447,15 @@ extern "C" {
 #define SCPI_UNITS_LIST_END       {NULL, SCPI_UNIT_NONE, 0}
     typedef struct _scpi_unit_def_t scpi_unit_def_t;
 
+    struct _scpi_unit_index_t {
+        const scpi_unit_def_t * units;
+        /* index of definition + 1 by hash of its name, 0 for empty slot */
+        uint16_t names[SCPI_UNITS_INDEX_SIZE];
+        /* index of base definition + 1 by its unit, 0 for empty slot */
+        uint16_t inverse[SCPI_UNITS_INDEX_SIZE];
+    };
+    typedef struct _scpi_unit_index_t scpi_unit_index_t;
+
     enum _scpi_special_number_t {
         SCPI_NUM_NUMBER,
         SCPI_NUM_MIN,
@@ -378,6 +477,22 @@ extern "C" {
 #define SCPI_CHOICE_LIST_END   {NULL, -1}
     typedef struct _scpi_choice_def_t scpi_choice_def_t;
 
+    struct _scpi_choice_index_t {
+        const scpi_choice_def_t * options;
+        /* FALSE if the list did not fit, options are searched linearly */
+        scpi_bool_t compiled;
+        /* first option + 1 by first letter of its name, 0 for none */
+        uint8_t first[32];
+        /* next option + 1 with the same first letter */
+        uint8_t next[SCPI_CHOICE_INDEX_MAX];
+        /* length of short and long form, 0 for pattern with number */
+        uint8_t short_len[SCPI_CHOICE_INDEX_MAX];
+        uint8_t long_len[SCPI_CHOICE_INDEX_MAX];
+        /* option + 1 by hash of its tag, 0 for empty slot */
+        uint8_t tags[2 * SCPI_CHOICE_INDEX_MAX];
+    };
+    typedef struct _scpi_choice_index_t scpi_choice_index_t;
+
     struct _scpi_param_list_t {
         const scpi_command_t * cmd;
         lex_state_t lex_state;
@@ -411,7 +526,31 @@ extern "C" {
 #if USE_COMMAND_TAGS
         int32_t tag;
 #endif /* USE_COMMAND_TAGS */
+#if USE_BLOCK_STREAMING
+        scpi_block_sink_t block_sink;
+#endif /* USE_BLOCK_STREAMING */
+    };
+
+    typedef struct _scpi_command_node_t scpi_command_node_t;
+
+    struct _scpi_command_node_t {
+        const char * mnemonic;
+        size_t len;
+        const scpi_command_node_t * child;
+        const scpi_command_node_t * sibling;
+        const scpi_command_t * command;
+        const scpi_command_t * query;
+    };
+
+    struct _scpi_precompiled_commands_t {
+        const scpi_command_t * cmdlist;
+        uint16_t size;
+        uint16_t buckets;
+        const uint16_t * displacements;
+        const uint16_t * slots;
+        const uint16_t * commands;
     };
+    typedef struct _scpi_precompiled_commands_t scpi_precompiled_commands_t;
 
     struct _scpi_interface_t {
         scpi_error_callback_t error;
@@ -419,11 +558,38 @@ extern "C" {
         scpi_write_control_t control;
         scpi_command_callback_t flush;
         scpi_command_callback_t reset;
+        scpi_write_vector_t writev;
+    };
+
+    /* read-only instrument definition, it can be shared by more sessions */
+    struct _scpi_definition_t {
+        const scpi_command_t * cmdlist;
+        const scpi_command_node_t * cmdtree;
+        const scpi_unit_def_t * units;
+        const scpi_unit_index_t * units_index;
+        const char * idn[4];
+#if USE_BLOCK_STREAMING
+        scpi_bool_t block_streaming;
+#endif
     };
+    typedef struct _scpi_definition_t scpi_definition_t;
 
     struct _scpi_t {
+        const scpi_definition_t * definition;
+#if USE_SESSION_DEFINITION
+        /* deprecated, definition of session initialized by SCPI_Init, changes are used by next SCPI_Parse */
         const scpi_command_t * cmdlist;
+        const scpi_unit_def_t * units;
+        const char * idn[4];
+        /* own definition of session initialized by SCPI_Init */
+        scpi_definition_t local_definition;
+#endif
         scpi_buffer_t buffer;
+        scpi_buffer_t output;
+        scpi_bool_t output_pending;
+        scpi_bool_t output_deadlocked;
+        /* part of current response was accepted by the interface */
+        scpi_bool_t output_started;
         scpi_param_list_t param_list;
         scpi_interface_t * interface;
         int_fast16_t output_count;
@@ -431,15 +597,38 @@ extern "C" {
         scpi_bool_t first_output;
         scpi_bool_t cmd_error;
         scpi_fifo_t error_queue;
+#if USE_LOCKFREE_ERROR_QUEUE
+        /* ESR bits of posted errors not yet applied */
+        volatile uint32_t error_posted;
+#endif
 #if USE_DEVICE_DEPENDENT_ERROR_INFORMATION && !USE_MEMORY_ALLOCATION_FREE
         scpi_error_info_heap_t error_info_heap;
 #endif
         scpi_reg_val_t registers[SCPI_REG_COUNT];
-        const scpi_unit_def_t * units;
+#if USE_REGISTER_CONDITION_SOURCE
+        scpi_reg_condition_t reg_condition[SCPI_REG_GROUP_COUNT];
+#endif
+#if USE_REGISTER_TRANSACTIONS
+        /* register transaction, values before first change */
+        int_fast16_t reg_transaction;
+        scpi_bool_t reg_changed[SCPI_REG_COUNT];
+        scpi_reg_val_t reg_old[SCPI_REG_COUNT];
+        scpi_bool_t srq_deferred;
+        scpi_bool_t srq_pending;
+#endif
+#if USE_ATOMIC_REGISTERS
+        /* posted bits of register halves, bytes with set, cleared and pulsed bits */
+        volatile uint32_t registers_posted[SCPI_REG_COUNT][2];
+        volatile uint32_t registers_dirty;
+#endif
         void * user_context;
         scpi_parser_state_t parser_state;
-        const char * idn[4];
         size_t arbitrary_remaining;
+        int result_precision;
+#if USE_BLOCK_STREAMING
+        scpi_block_producer_t block_producer;
+        size_t block_produce_remaining;
+#endif
     };
 
     enum _scpi_array_format_t {
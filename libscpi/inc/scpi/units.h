@@ -47,6 +47,11 @@ extern "C" {
     extern const scpi_unit_def_t scpi_units_def[];
     extern const scpi_choice_def_t scpi_special_numbers_def[];
 
+#if USE_SESSION_DEFINITION
+    size_t SCPI_CompileUnits(scpi_t * context, scpi_unit_index_t * index);
+#endif
+    size_t SCPI_DefinitionCompileUnits(scpi_definition_t * definition, scpi_unit_index_t * index);
+
     scpi_bool_t SCPI_ParamNumber(scpi_t * context, const scpi_choice_def_t * special, scpi_number_t * value, scpi_bool_t mandatory);
 
     scpi_bool_t SCPI_ParamTranslateNumberVal(scpi_t * context, scpi_parameter_t * parameter);
@@ -0,0 +1,229 @@
+/*-
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2012-2018, Jan Breuer
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file   bignum.c
+ *
+ * @brief  Big unsigned integers for exact number conversions
+ *
+ * Only operations needed by exact float to string and string to float
+ * conversions are implemented. Storage is provided by the caller, so no
+ * memory is allocated.
+ */
+
+#include <string.h>
+
+#include "bignum_private.h"
+
+/**
+ * Initialize big integer to 64bit value
+ * @param b
+ * @param storage - limbs of the number
+ * @param val
+ */
+void bignumInit(bignum_t * b, uint32_t * storage, uint64_t val) {
+    b->d = storage;
+    b->d[0] = (uint32_t) val;
+    b->d[1] = (uint32_t) (val >> 32);
+    b->n = b->d[1] ? 2 : (b->d[0] ? 1 : 0);
+}
+
+/**
+ * Copy value of big integer to another one with its own storage
+ * @param dst
+ * @param src
+ */
+void bignumCopy(bignum_t * dst, const bignum_t * src) {
+    memcpy(dst->d, src->d, src->n * sizeof (*src->d));
+    dst->n = src->n;
+}
+
+/**
+ * Multiply big integer by small number and add another small number
+ * @param b
+ * @param m - multiplier
+ * @param a - addend
+ */
+void bignumMulAddSmall(bignum_t * b, uint32_t m, uint32_t a) {
+    uint64_t carry = a;
+    int i;
+
+    for (i = 0; i < b->n; i++) {
+        carry += (uint64_t) b->d[i] * m;
+        b->d[i] = (uint32_t) carry;
+        carry >>= 32;
+    }
+    if (carry) {
+        b->d[b->n++] = (uint32_t) carry;
+    }
+}
+
+/**
+ * Multiply big integer by 5^k
+ * @param b
+ * @param k
+ */
+void bignumMulPow5(bignum_t * b, int k) {
+    static const uint32_t pow5[] = {
+        1ul, 5ul, 25ul, 125ul, 625ul, 3125ul, 15625ul, 78125ul, 390625ul,
+        1953125ul, 9765625ul, 48828125ul, 244140625ul, 1220703125ul
+    };
+
+    for (; k >= 13; k -= 13) {
+        bignumMulAddSmall(b, pow5[13], 0);
+    }
+    if (k > 0) {
+        bignumMulAddSmall(b, pow5[k], 0);
+    }
+}
+
+/**
+ * Multiply big integer by 10^k
+ * @param b
+ * @param k
+ */
+void bignumMulPow10(bignum_t * b, int k) {
+    bignumMulPow5(b, k);
+    bignumShiftLeft(b, k);
+}
+
+/**
+ * Multiply big integer by 2^shift
+ * @param b
+ * @param shift
+ */
+void bignumShiftLeft(bignum_t * b, int shift) {
+    const int words = shift / 32;
+    const int bits = shift % 32;
+    uint32_t carry = 0;
+    uint32_t tmp;
+    int i;
+
+    if (b->n == 0) {
+        return;
+    }
+
+    if (bits) {
+        for (i = 0; i < b->n; i++) {
+            tmp = b->d[i] >> (32 - bits);
+            b->d[i] = (b->d[i] << bits) | carry;
+            carry = tmp;
+        }
+        if (carry) {
+            b->d[b->n++] = carry;
+        }
+    }
+
+    if (words) {
+        for (i = b->n - 1; i >= 0; i--) {
+            b->d[i + words] = b->d[i];
+        }
+        for (i = 0; i < words; i++) {
+            b->d[i] = 0;
+        }
+        b->n += words;
+    }
+}
+
+/**
+ * Add two big integers, result can be the same as one of operands
+ * @param result
+ * @param a
+ * @param b
+ */
+void bignumAdd(bignum_t * result, const bignum_t * a, const bignum_t * b) {
+    const int n = (a->n > b->n) ? a->n : b->n;
+    uint64_t carry = 0;
+    int i;
+
+    for (i = 0; i < n; i++) {
+        carry += (uint64_t) ((i < a->n) ? a->d[i] : 0) + ((i < b->n) ? b->d[i] : 0);
+        result->d[i] = (uint32_t) carry;
+        carry >>= 32;
+    }
+    result->n = n;
+    if (carry) {
+        result->d[result->n++] = (uint32_t) carry;
+    }
+}
+
+/**
+ * Subtract big integers a -= b, a must not be less than b
+ * @param a
+ * @param b
+ */
+void bignumSub(bignum_t * a, const bignum_t * b) {
+    uint64_t sub;
+    uint32_t borrow = 0;
+    int i;
+
+    for (i = 0; i < a->n; i++) {
+        sub = (uint64_t) ((i < b->n) ? b->d[i] : 0) + borrow;
+        borrow = (a->d[i] < sub) ? 1 : 0;
+        a->d[i] = (uint32_t) (a->d[i] - sub);
+    }
+    while ((a->n > 0) && (a->d[a->n - 1] == 0)) {
+        a->n--;
+    }
+}
+
+/**
+ * Compare two big integers
+ * @param a
+ * @param b
+ * @return -1, 0 or 1
+ */
+int bignumCompare(const bignum_t * a, const bignum_t * b) {
+    int i;
+
+    if (a->n != b->n) {
+        return (a->n < b->n) ? -1 : 1;
+    }
+    for (i = a->n - 1; i >= 0; i--) {
+        if (a->d[i] != b->d[i]) {
+            return (a->d[i] < b->d[i]) ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Divide r by s, r is replaced by the remainder. Quotient must be less than 10.
+ * @param r
+ * @param s
+ * @return quotient
+ */
+int bignumDivDigit(bignum_t * r, const bignum_t * s) {
+    int d = 0;
+
+    while (bignumCompare(r, s) >= 0) {
+        bignumSub(r, s);
+        d++;
+    }
+    return d;
+}
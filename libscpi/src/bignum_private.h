@@ -0,0 +1,68 @@
+/*-
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2012-2018, Jan Breuer
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file   bignum_private.h
+ *
+ * @brief  Big unsigned integers for exact number conversions
+ *
+ *
+ */
+
+#ifndef SCPI_BIGNUM_PRIVATE_H
+#define SCPI_BIGNUM_PRIVATE_H
+
+#include "scpi/types.h"
+#include "utils_private.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    /* big integer in storage provided by caller, big enough for all results */
+    typedef struct {
+        uint32_t * d; /* limbs, least significant first */
+        int n; /* number of used limbs */
+    } bignum_t;
+
+    void bignumInit(bignum_t * b, uint32_t * storage, uint64_t val) LOCAL;
+    void bignumCopy(bignum_t * dst, const bignum_t * src) LOCAL;
+    void bignumMulAddSmall(bignum_t * b, uint32_t m, uint32_t a) LOCAL;
+    void bignumMulPow5(bignum_t * b, int k) LOCAL;
+    void bignumMulPow10(bignum_t * b, int k) LOCAL;
+    void bignumShiftLeft(bignum_t * b, int shift) LOCAL;
+    void bignumAdd(bignum_t * result, const bignum_t * a, const bignum_t * b) LOCAL;
+    void bignumSub(bignum_t * a, const bignum_t * b) LOCAL;
+    int bignumCompare(const bignum_t * a, const bignum_t * b) LOCAL;
+    int bignumDivDigit(bignum_t * r, const bignum_t * s) LOCAL;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SCPI_BIGNUM_PRIVATE_H */
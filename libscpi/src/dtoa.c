@@ -0,0 +1,749 @@
+/*-
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2012-2018, Jan Breuer
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file   dtoa.c
+ *
+ * @brief  Conversion of floating point numbers to string
+ *
+ * Shortest representation, which converts back to the same number, and
+ * correctly rounded representation with given number of significant digits
+ * are found by Grisu3 algorithm by Florian Loitsch, "Printing Floating-Point
+ * Numbers Quickly and Accurately with Integers", PLDI 2010. Numbers which
+ * Grisu3 can not guarantee (a small fraction) are converted exactly by big integer
+ * arithmetic. Output does not depend on locale.
+ */
+
+#include <string.h>
+
+#include "dtoa_private.h"
+#include "bignum_private.h"
+
+typedef struct {
+    uint64_t f;
+    int e;
+} diy_fp_t;
+
+/* normalized 10^k for k = -348, -340, ..., 340 */
+static const diy_fp_t cached_powers[] = {
+    {0xfa8fd5a0081c0288ull, -1220}, {0xbaaee17fa23ebf76ull, -1193}, {0x8b16fb203055ac76ull, -1166},
+    {0xcf42894a5dce35eaull, -1140}, {0x9a6bb0aa55653b2dull, -1113}, {0xe61acf033d1a45dfull, -1087},
+    {0xab70fe17c79ac6caull, -1060}, {0xff77b1fcbebcdc4full, -1034}, {0xbe5691ef416bd60cull, -1007},
+    {0x8dd01fad907ffc3cull, -980}, {0xd3515c2831559a83ull, -954}, {0x9d71ac8fada6c9b5ull, -927},
+    {0xea9c227723ee8bcbull, -901}, {0xaecc49914078536dull, -874}, {0x823c12795db6ce57ull, -847},
+    {0xc21094364dfb5637ull, -821}, {0x9096ea6f3848984full, -794}, {0xd77485cb25823ac7ull, -768},
+    {0xa086cfcd97bf97f4ull, -741}, {0xef340a98172aace5ull, -715}, {0xb23867fb2a35b28eull, -688},
+    {0x84c8d4dfd2c63f3bull, -661}, {0xc5dd44271ad3cdbaull, -635}, {0x936b9fcebb25c996ull, -608},
+    {0xdbac6c247d62a584ull, -582}, {0xa3ab66580d5fdaf6ull, -555}, {0xf3e2f893dec3f126ull, -529},
+    {0xb5b5ada8aaff80b8ull, -502}, {0x87625f056c7c4a8bull, -475}, {0xc9bcff6034c13053ull, -449},
+    {0x964e858c91ba2655ull, -422}, {0xdff9772470297ebdull, -396}, {0xa6dfbd9fb8e5b88full, -369},
+    {0xf8a95fcf88747d94ull, -343}, {0xb94470938fa89bcfull, -316}, {0x8a08f0f8bf0f156bull, -289},
+    {0xcdb02555653131b6ull, -263}, {0x993fe2c6d07b7facull, -236}, {0xe45c10c42a2b3b06ull, -210},
+    {0xaa242499697392d3ull, -183}, {0xfd87b5f28300ca0eull, -157}, {0xbce5086492111aebull, -130},
+    {0x8cbccc096f5088ccull, -103}, {0xd1b71758e219652cull, -77}, {0x9c40000000000000ull, -50},
+    {0xe8d4a51000000000ull, -24}, {0xad78ebc5ac620000ull, 3}, {0x813f3978f8940984ull, 30},
+    {0xc097ce7bc90715b3ull, 56}, {0x8f7e32ce7bea5c70ull, 83}, {0xd5d238a4abe98068ull, 109},
+    {0x9f4f2726179a2245ull, 136}, {0xed63a231d4c4fb27ull, 162}, {0xb0de65388cc8ada8ull, 189},
+    {0x83c7088e1aab65dbull, 216}, {0xc45d1df942711d9aull, 242}, {0x924d692ca61be758ull, 269},
+    {0xda01ee641a708deaull, 295}, {0xa26da3999aef774aull, 322}, {0xf209787bb47d6b85ull, 348},
+    {0xb454e4a179dd1877ull, 375}, {0x865b86925b9bc5c2ull, 402}, {0xc83553c5c8965d3dull, 428},
+    {0x952ab45cfa97a0b3ull, 455}, {0xde469fbd99a05fe3ull, 481}, {0xa59bc234db398c25ull, 508},
+    {0xf6c69a72a3989f5cull, 534}, {0xb7dcbf5354e9beceull, 561}, {0x88fcf317f22241e2ull, 588},
+    {0xcc20ce9bd35c78a5ull, 614}, {0x98165af37b2153dfull, 641}, {0xe2a0b5dc971f303aull, 667},
+    {0xa8d9d1535ce3b396ull, 694}, {0xfb9b7cd9a4a7443cull, 720}, {0xbb764c4ca7a44410ull, 747},
+    {0x8bab8eefb6409c1aull, 774}, {0xd01fef10a657842cull, 800}, {0x9b10a4e5e9913129ull, 827},
+    {0xe7109bfba19c0c9dull, 853}, {0xac2820d9623bf429ull, 880}, {0x80444b5e7aa7cf85ull, 907},
+    {0xbf21e44003acdd2dull, 933}, {0x8e679c2f5e44ff8full, 960}, {0xd433179d9c8cb841ull, 986},
+    {0x9e19db92b4e31ba9ull, 1013}, {0xeb96bf6ebadf77d9ull, 1039}, {0xaf87023b9bf0ee6bull, 1066}
+};
+
+static const uint64_t pow10_table[] = {
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull,
+    100000000ull, 1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull,
+    10000000000000ull, 100000000000000ull, 1000000000000000ull, 10000000000000000ull,
+    100000000000000000ull, 1000000000000000000ull, 10000000000000000000ull
+};
+
+#define DTOA_DIGITS_MAX 20
+
+/* enough for digits of any double scaled by a power of ten */
+#define DTOA_BIGNUM_LIMBS 40
+
+/**
+ * Multiply two numbers, result is rounded
+ * @param x
+ * @param y
+ * @return
+ */
+static diy_fp_t diyFpMultiply(diy_fp_t x, diy_fp_t y) {
+    const uint64_t mask32 = 0xFFFFFFFFull;
+    uint64_t a = x.f >> 32;
+    uint64_t b = x.f & mask32;
+    uint64_t c = y.f >> 32;
+    uint64_t d = y.f & mask32;
+    uint64_t ac = a * c;
+    uint64_t bc = b * c;
+    uint64_t ad = a * d;
+    uint64_t bd = b * d;
+    uint64_t tmp = (bd >> 32) + (ad & mask32) + (bc & mask32);
+    diy_fp_t result;
+
+    tmp += 1ull << 31;
+    result.f = ac + (ad >> 32) + (bc >> 32) + (tmp >> 32);
+    result.e = x.e + y.e + 64;
+    return result;
+}
+
+/**
+ * Shift number so the highest bit is set
+ * @param x
+ * @return
+ */
+static diy_fp_t diyFpNormalize(diy_fp_t x) {
+    while (!(x.f & 0x8000000000000000ull)) {
+        x.f <<= 1;
+        x.e--;
+    }
+    return x;
+}
+
+/**
+ * Compute normalized boundaries of the interval of numbers rounding to x
+ * @param x - number with significand including hidden bit
+ * @param significand_size - number of significand bits without hidden bit
+ * @param min_e - binary exponent of denormal numbers
+ * @param minus - lower boundary
+ * @param plus - upper boundary
+ */
+static void diyFpBoundaries(diy_fp_t x, int significand_size, int min_e, diy_fp_t * minus, diy_fp_t * plus) {
+    const uint64_t hidden = 1ull << significand_size;
+
+    plus->f = (x.f << 1) + 1;
+    plus->e = x.e - 1;
+    while (!(plus->f & (hidden << 1))) {
+        plus->f <<= 1;
+        plus->e--;
+    }
+    plus->f <<= 64 - significand_size - 2;
+    plus->e -= 64 - significand_size - 2;
+
+    if ((x.f == hidden) && (x.e != min_e)) {
+        /* lower neighbour is closer */
+        minus->f = (x.f << 2) - 1;
+        minus->e = x.e - 2;
+    } else {
+        minus->f = (x.f << 1) - 1;
+        minus->e = x.e - 1;
+    }
+    minus->f <<= minus->e - plus->e;
+    minus->e = plus->e;
+}
+
+/**
+ * Find cached power of ten c = 10^mk, so that binary exponent of c * 2^e
+ * is in the range -60 to -32 required by digit generation
+ * @param e - binary exponent of normalized number
+ * @param mk - decimal exponent of the cached power
+ * @return
+ */
+static diy_fp_t cachedPower(int e, int * mk) {
+    /* k = ceil((-60 - (e + 64) + 63) * log10(2)) */
+    double dk = (-61 - e) * 0.30102999566398114;
+    int k = (int) dk;
+    int index;
+
+    if (dk - k > 0.0) {
+        k++;
+    }
+    index = (348 + k - 1) / 8 + 1;
+    *mk = -348 + index * 8;
+    return cached_powers[index];
+}
+
+/**
+ * Count decimal digits of integral part of scaled number
+ * @param integrals
+ * @return
+ */
+static int integralDigits(uint32_t integrals) {
+    int kappa = 0;
+
+    while ((kappa < 10) && (integrals >= pow10_table[kappa])) {
+        kappa++;
+    }
+    return kappa;
+}
+
+/**
+ * Move last digit closer to the exact value and check that the digits are
+ * the shortest and closest despite the error of the scaled numbers
+ * @param buffer - digits
+ * @param len - number of digits
+ * @param distance_too_high_w - distance from the number to the unsafe upper boundary
+ * @param unsafe_interval - width of interval including the error
+ * @param rest - distance from the digits to the unsafe upper boundary
+ * @param ten_kappa - weight of the last digit
+ * @param unit - error of the scaled numbers
+ * @return TRUE if the digits are correct
+ */
+static scpi_bool_t roundWeed(char * buffer, int len, uint64_t distance_too_high_w, uint64_t unsafe_interval, uint64_t rest, uint64_t ten_kappa, uint64_t unit) {
+    uint64_t small_distance = distance_too_high_w - unit;
+    uint64_t big_distance = distance_too_high_w + unit;
+
+    while ((rest < small_distance) && (unsafe_interval - rest >= ten_kappa)
+            && ((rest + ten_kappa < small_distance)
+            || (small_distance - rest >= rest + ten_kappa - small_distance))) {
+        buffer[len - 1]--;
+        rest += ten_kappa;
+    }
+
+    /* digits closer to the number could exist within the error */
+    if ((rest < big_distance) && (unsafe_interval - rest >= ten_kappa)
+            && ((rest + ten_kappa < big_distance)
+            || (big_distance - rest > rest + ten_kappa - big_distance))) {
+        return FALSE;
+    }
+
+    return ((2 * unit <= rest) && (rest <= unsafe_interval - 4 * unit)) ? TRUE : FALSE;
+}
+
+/**
+ * Generate shortest digits of number in the interval (low, high)
+ * @param low - scaled lower boundary
+ * @param w - scaled number
+ * @param high - scaled upper boundary
+ * @param buffer - digits
+ * @param len - number of digits
+ * @param kappa - decimal exponent of the last digit
+ * @return TRUE if the digits are guaranteed to be correct
+ */
+static scpi_bool_t digitGen(diy_fp_t low, diy_fp_t w, diy_fp_t high, char * buffer, int * len, int * kappa) {
+    const int shift = -w.e;
+    const uint64_t one = 1ull << shift;
+    uint64_t unit = 1;
+    uint64_t too_high = high.f + unit;
+    uint64_t unsafe_interval = too_high - (low.f - unit);
+    uint32_t integrals = (uint32_t) (too_high >> shift);
+    uint64_t fractionals = too_high & (one - 1);
+    uint64_t rest;
+    uint32_t d;
+
+    *kappa = integralDigits(integrals);
+    *len = 0;
+    while (*kappa > 0) {
+        d = (uint32_t) (integrals / pow10_table[*kappa - 1]);
+        integrals = (uint32_t) (integrals % pow10_table[*kappa - 1]);
+        buffer[(*len)++] = (char) ('0' + d);
+        (*kappa)--;
+        rest = ((uint64_t) integrals << shift) + fractionals;
+        if (rest < unsafe_interval) {
+            return roundWeed(buffer, *len, too_high - w.f, unsafe_interval, rest, pow10_table[*kappa] << shift, unit);
+        }
+    }
+
+    while (*len < DTOA_DIGITS_MAX) {
+        fractionals *= 10;
+        unit *= 10;
+        unsafe_interval *= 10;
+        d = (uint32_t) (fractionals >> shift);
+        buffer[(*len)++] = (char) ('0' + d);
+        fractionals &= one - 1;
+        (*kappa)--;
+        if (fractionals < unsafe_interval) {
+            return roundWeed(buffer, *len, (too_high - w.f) * unit, unsafe_interval, fractionals, one, unit);
+        }
+    }
+
+    return FALSE;
+}
+
+/**
+ * Find shortest digits of positive number by Grisu3
+ * @param v - number with significand including hidden bit
+ * @param significand_size - number of significand bits without hidden bit
+ * @param min_e - binary exponent of denormal numbers
+ * @param buffer - digits
+ * @param len - number of digits
+ * @param K - decimal exponent, value = digits * 10^K
+ * @return FALSE if the result can not be guaranteed
+ */
+static scpi_bool_t grisu3(diy_fp_t v, int significand_size, int min_e, char * buffer, int * len, int * K) {
+    diy_fp_t w_m;
+    diy_fp_t w_p;
+    diy_fp_t c_mk;
+    int mk;
+    int kappa;
+
+    diyFpBoundaries(v, significand_size, min_e, &w_m, &w_p);
+    c_mk = cachedPower(w_p.e, &mk);
+    if (!digitGen(diyFpMultiply(w_m, c_mk), diyFpMultiply(diyFpNormalize(v), c_mk),
+            diyFpMultiply(w_p, c_mk), buffer, len, &kappa)) {
+        return FALSE;
+    }
+    *K = kappa - mk;
+    return TRUE;
+}
+
+/**
+ * Round counted digits by the rest and check that the rounding direction
+ * does not depend on the error of the scaled number
+ * @param buffer - digits
+ * @param len - number of digits
+ * @param rest - rest of the number after the last digit
+ * @param ten_kappa - weight of the last digit
+ * @param unit - error of the scaled number
+ * @param kappa - decimal exponent of the last digit
+ * @return TRUE if the digits are correctly rounded
+ */
+static scpi_bool_t roundWeedCounted(char * buffer, int len, uint64_t rest, uint64_t ten_kappa, uint64_t unit, int * kappa) {
+    int i;
+
+    if ((unit >= ten_kappa) || (ten_kappa - unit <= unit)) {
+        return FALSE;
+    }
+
+    /* round down */
+    if ((ten_kappa - rest > rest) && (ten_kappa - 2 * rest >= 2 * unit)) {
+        return TRUE;
+    }
+
+    /* round up */
+    if ((rest > unit) && (ten_kappa - (rest - unit) <= (rest - unit))) {
+        for (i = len - 1; (i > 0) && (buffer[i] == '9'); i--) {
+            buffer[i] = '0';
+        }
+        if (buffer[i] == '9') {
+            /* 99.9 -> 100 */
+            buffer[0] = '1';
+            (*kappa)++;
+        } else {
+            buffer[i]++;
+        }
+        return TRUE;
+    }
+
+    /* too close to the middle, including exact ties */
+    return FALSE;
+}
+
+/**
+ * Find given number of correctly rounded digits of positive number
+ * @param v - number with significand including hidden bit
+ * @param precision - number of significant digits
+ * @param buffer - digits
+ * @param len - number of digits
+ * @param K - decimal exponent, value = digits * 10^K
+ * @return FALSE if the result can not be guaranteed
+ */
+static scpi_bool_t grisu3Counted(diy_fp_t v, int precision, char * buffer, int * len, int * K) {
+    diy_fp_t w;
+    diy_fp_t c_mk;
+    int mk;
+    int kappa;
+    int shift;
+    uint64_t one;
+    uint64_t w_error = 1;
+    uint64_t fractionals;
+    uint32_t integrals;
+    uint32_t d;
+
+    w = diyFpNormalize(v);
+    c_mk = cachedPower(w.e, &mk);
+    w = diyFpMultiply(w, c_mk);
+    shift = -w.e;
+    one = 1ull << shift;
+    integrals = (uint32_t) (w.f >> shift);
+    fractionals = w.f & (one - 1);
+
+    kappa = integralDigits(integrals);
+    *len = 0;
+    while ((kappa > 0) && (*len < precision)) {
+        d = (uint32_t) (integrals / pow10_table[kappa - 1]);
+        integrals = (uint32_t) (integrals % pow10_table[kappa - 1]);
+        buffer[(*len)++] = (char) ('0' + d);
+        kappa--;
+    }
+
+    if (*len == precision) {
+        if (!roundWeedCounted(buffer, *len, ((uint64_t) integrals << shift) + fractionals,
+                pow10_table[kappa] << shift, w_error, &kappa)) {
+            return FALSE;
+        }
+        *K = kappa - mk;
+        return TRUE;
+    }
+
+    while ((*len < precision) && (fractionals > w_error)) {
+        fractionals *= 10;
+        w_error *= 10;
+        d = (uint32_t) (fractionals >> shift);
+        buffer[(*len)++] = (char) ('0' + d);
+        fractionals &= one - 1;
+        kappa--;
+    }
+
+    if ((*len < precision) || !roundWeedCounted(buffer, *len, fractionals, one, w_error, &kappa)) {
+        return FALSE;
+    }
+    *K = kappa - mk;
+    return TRUE;
+}
+
+/**
+ * Find digits of positive number exactly by big integer arithmetic, used
+ * when Grisu3 can not guarantee the result
+ * @param f - significand including hidden bit
+ * @param e - binary exponent
+ * @param lower_closer - lower neighbour is closer than the upper one
+ * @param precision - number of significant digits, 0 = shortest
+ * representation which converts back to the same value
+ * @param buffer - digits
+ * @param len - number of digits
+ * @param K - decimal exponent, value = digits * 10^K
+ */
+static void bignumDigits(uint64_t f, int e, scpi_bool_t lower_closer, int precision, char * buffer, int * len, int * K) {
+    /* value = r / s * 10^k, boundaries are (r - mm) / s and (r + mp) / s */
+    uint32_t storage[5][DTOA_BIGNUM_LIMBS];
+    bignum_t r;
+    bignum_t s;
+    bignum_t mp;
+    bignum_t mm;
+    bignum_t t;
+    const scpi_bool_t even = (f & 1) ? FALSE : TRUE;
+    const int shift = lower_closer ? 2 : 1;
+    scpi_bool_t low = FALSE;
+    scpi_bool_t high = FALSE;
+    double dk;
+    int bits = 0;
+    int cmp;
+    int k;
+    int d = 0;
+    int i;
+
+    bignumInit(&r, storage[0], f);
+    bignumShiftLeft(&r, shift + (e > 0 ? e : 0));
+    bignumInit(&s, storage[1], 1);
+    bignumShiftLeft(&s, shift + (e < 0 ? -e : 0));
+    bignumInit(&mm, storage[2], 1);
+    bignumShiftLeft(&mm, e > 0 ? e : 0);
+    bignumInit(&mp, storage[3], 0);
+    bignumCopy(&mp, &mm);
+    if (lower_closer) {
+        bignumShiftLeft(&mp, 1);
+    }
+    bignumInit(&t, storage[4], 0);
+
+    /* estimate k = ceil(log10(value)), it can be one less */
+    while ((bits < 64) && (f >> bits)) {
+        bits++;
+    }
+    dk = (e + bits - 1) * 0.30102999566398114 - 1e-10;
+    k = (int) dk;
+    if (dk - k > 0.0) {
+        k++;
+    }
+    if (k >= 0) {
+        bignumMulPow10(&s, k);
+    } else {
+        bignumMulPow10(&r, -k);
+        bignumMulPow10(&mp, -k);
+        bignumMulPow10(&mm, -k);
+    }
+
+    if (precision > 0) {
+        high = (bignumCompare(&r, &s) >= 0) ? TRUE : FALSE;
+    } else {
+        bignumAdd(&t, &r, &mp);
+        cmp = bignumCompare(&t, &s);
+        high = (even ? cmp >= 0 : cmp > 0) ? TRUE : FALSE;
+    }
+    if (high) {
+        bignumMulAddSmall(&s, 10, 0);
+        k++;
+    }
+
+    *len = 0;
+    if (precision > 0) {
+        while (*len < precision) {
+            bignumMulAddSmall(&r, 10, 0);
+            buffer[(*len)++] = (char) ('0' + bignumDivDigit(&r, &s));
+        }
+
+        /* round half to even */
+        bignumShiftLeft(&r, 1);
+        cmp = bignumCompare(&r, &s);
+        if ((cmp > 0) || ((cmp == 0) && ((buffer[*len - 1] - '0') & 1))) {
+            for (i = *len - 1; (i >= 0) && (buffer[i] == '9'); i--) {
+                buffer[i] = '0';
+            }
+            if (i < 0) {
+                buffer[0] = '1';
+                k++;
+            } else {
+                buffer[i]++;
+            }
+        }
+    } else {
+        while (*len < DTOA_DIGITS_MAX) {
+            bignumMulAddSmall(&r, 10, 0);
+            bignumMulAddSmall(&mp, 10, 0);
+            bignumMulAddSmall(&mm, 10, 0);
+            d = bignumDivDigit(&r, &s);
+            cmp = bignumCompare(&r, &mm);
+            low = (even ? cmp <= 0 : cmp < 0) ? TRUE : FALSE;
+            bignumAdd(&t, &r, &mp);
+            cmp = bignumCompare(&t, &s);
+            high = (even ? cmp >= 0 : cmp > 0) ? TRUE : FALSE;
+            if (low || high) {
+                break;
+            }
+            buffer[(*len)++] = (char) ('0' + d);
+        }
+
+        /* last digit is the closer one of both possibilities */
+        if (low && high) {
+            bignumAdd(&t, &r, &r);
+            cmp = bignumCompare(&t, &s);
+            if ((cmp > 0) || ((cmp == 0) && (d & 1))) {
+                d++;
+            }
+        } else if (high) {
+            d++;
+        }
+        buffer[(*len)++] = (char) ('0' + d);
+    }
+
+    *K = k - *len;
+}
+
+/**
+ * Find digits of positive number
+ * @param v - number with significand including hidden bit
+ * @param significand_size - number of significand bits without hidden bit
+ * @param min_e - binary exponent of denormal numbers
+ * @param precision - number of significant digits, 0 = shortest
+ * representation which converts back to the same value
+ * @param buffer - digits
+ * @param len - number of digits
+ * @param K - decimal exponent, value = digits * 10^K
+ */
+static void findDigits(diy_fp_t v, int significand_size, int min_e, int precision, char * buffer, int * len, int * K) {
+    scpi_bool_t done;
+
+    if (precision > 0) {
+        done = grisu3Counted(v, precision, buffer, len, K);
+    } else {
+        done = grisu3(v, significand_size, min_e, buffer, len, K);
+    }
+
+    if (!done) {
+        bignumDigits(v.f, v.e, ((v.f == (1ull << significand_size)) && (v.e != min_e)) ? TRUE : FALSE,
+                precision, buffer, len, K);
+    }
+
+    while ((*len > 1) && (buffer[*len - 1] == '0')) {
+        (*len)--;
+        (*K)++;
+    }
+}
+
+/**
+ * Write digits in %g style notation
+ * @param negative - write minus sign
+ * @param buffer - digits
+ * @param len - number of digits
+ * @param K - decimal exponent, value = digits * 10^K
+ * @param exponent_limit - exponent notation is used if decimal exponent
+ * is less than -4 or greater or equal than this limit
+ * @param str - output string
+ * @param str_len - size of output string
+ * @return number of characters written to str (without '\0')
+ */
+static size_t formatDigits(scpi_bool_t negative, const char * buffer, int len, int K, int exponent_limit, char * str, size_t str_len) {
+    char out[DTOA_DIGITS_MAX + 16];
+    size_t pos = 0;
+    int exponent = len + K - 1;
+    int i;
+
+    if (negative) {
+        out[pos++] = '-';
+    }
+
+    if ((exponent >= -4) && (exponent < exponent_limit)) {
+        if (K >= 0) {
+            memcpy(out + pos, buffer, len);
+            pos += len;
+            for (i = 0; i < K; i++) {
+                out[pos++] = '0';
+            }
+        } else if (exponent >= 0) {
+            memcpy(out + pos, buffer, exponent + 1);
+            pos += exponent + 1;
+            out[pos++] = '.';
+            memcpy(out + pos, buffer + exponent + 1, len - exponent - 1);
+            pos += len - exponent - 1;
+        } else {
+            out[pos++] = '0';
+            out[pos++] = '.';
+            for (i = exponent + 1; i < 0; i++) {
+                out[pos++] = '0';
+            }
+            memcpy(out + pos, buffer, len);
+            pos += len;
+        }
+    } else {
+        out[pos++] = buffer[0];
+        if (len > 1) {
+            out[pos++] = '.';
+            memcpy(out + pos, buffer + 1, len - 1);
+            pos += len - 1;
+        }
+        out[pos++] = 'e';
+        if (exponent < 0) {
+            out[pos++] = '-';
+            exponent = -exponent;
+        } else {
+            out[pos++] = '+';
+        }
+        if (exponent >= 100) {
+            out[pos++] = (char) ('0' + exponent / 100);
+        }
+        out[pos++] = (char) ('0' + (exponent / 10) % 10);
+        out[pos++] = (char) ('0' + exponent % 10);
+    }
+
+    if (str_len == 0) {
+        return 0;
+    }
+    if (pos >= str_len) {
+        pos = str_len - 1;
+    }
+    memcpy(str, out, pos);
+    str[pos] = '\0';
+    return pos;
+}
+
+/**
+ * Write special value
+ * @return number of characters written to str (without '\0')
+ */
+static size_t formatSpecial(const char * text, char * str, size_t str_len) {
+    return formatDigits(FALSE, text, strlen(text), 0, DTOA_DIGITS_MAX, str, str_len);
+}
+
+/**
+ * Convert double to string
+ * @param val - value
+ * @param str - output string
+ * @param len - size of output string
+ * @param precision - number of significant digits (at most 20 are
+ * generated), 0 = shortest representation which converts back to the same
+ * value
+ * @return number of characters written to str (without '\0')
+ */
+size_t dtoaDouble(double val, char * str, size_t len, int precision) {
+    char buffer[DTOA_DIGITS_MAX];
+    uint64_t bits;
+    diy_fp_t v;
+    int exponent;
+    int digits;
+    int K;
+    scpi_bool_t negative;
+
+    memcpy(&bits, &val, sizeof (bits));
+    negative = (bits >> 63) ? TRUE : FALSE;
+    exponent = (int) ((bits >> 52) & 0x7FF);
+    v.f = bits & 0x000FFFFFFFFFFFFFull;
+
+    if (exponent == 0x7FF) {
+        return formatSpecial(v.f ? "nan" : (negative ? "-inf" : "inf"), str, len);
+    }
+
+    if (exponent == 0 && v.f == 0) {
+        return formatSpecial(negative ? "-0" : "0", str, len);
+    }
+
+    if (exponent) {
+        v.f |= 0x0010000000000000ull;
+        v.e = exponent - 1075;
+    } else {
+        v.e = -1074;
+    }
+
+    if (precision > DTOA_DIGITS_MAX) {
+        precision = DTOA_DIGITS_MAX;
+    }
+    findDigits(v, 52, -1074, precision, buffer, &digits, &K);
+    return formatDigits(negative, buffer, digits, K, precision > 0 ? precision : 15, str, len);
+}
+
+/**
+ * Convert float to string
+ * @param val - value
+ * @param str - output string
+ * @param len - size of output string
+ * @param precision - number of significant digits (at most 20 are
+ * generated), 0 = shortest representation which converts back to the same
+ * value
+ * @return number of characters written to str (without '\0')
+ */
+size_t dtoaFloat(float val, char * str, size_t len, int precision) {
+    char buffer[DTOA_DIGITS_MAX];
+    uint32_t bits;
+    diy_fp_t v;
+    int exponent;
+    int digits;
+    int K;
+    scpi_bool_t negative;
+
+    memcpy(&bits, &val, sizeof (bits));
+    negative = (bits >> 31) ? TRUE : FALSE;
+    exponent = (int) ((bits >> 23) & 0xFF);
+    v.f = bits & 0x007FFFFFul;
+
+    if (exponent == 0xFF) {
+        return formatSpecial(v.f ? "nan" : (negative ? "-inf" : "inf"), str, len);
+    }
+
+    if (exponent == 0 && v.f == 0) {
+        return formatSpecial(negative ? "-0" : "0", str, len);
+    }
+
+    if (exponent) {
+        v.f |= 0x00800000ul;
+        v.e = exponent - 150;
+    } else {
+        v.e = -149;
+    }
+
+    if (precision > DTOA_DIGITS_MAX) {
+        precision = DTOA_DIGITS_MAX;
+    }
+    findDigits(v, 23, -149, precision, buffer, &digits, &K);
+    return formatDigits(negative, buffer, digits, K, precision > 0 ? precision : 6, str, len);
+}
@@ -61,7 +61,8 @@ void SCPI_ErrorInit(scpi_t * context, scpi_error_t * data, int16_t size) {
  * @param context scpi context
  */
 static void SCPI_ErrorEmitEmpty(scpi_t * context) {
-    if ((SCPI_ErrorCount(context) == 0) && (SCPI_RegGet(context, SCPI_REG_STB) & STB_QMA)) {
+    /* stored value is enough for QMA, condition sources are not sampled */
+    if ((SCPI_ErrorCount(context) == 0) && (context->registers[SCPI_REG_STB] & STB_QMA)) {
         SCPI_RegClearBits(context, SCPI_REG_STB, STB_QMA);
 
         if (context->interface && context->interface->error) {
@@ -107,6 +108,9 @@ void SCPI_ErrorClear(scpi_t * context) {
  */
 scpi_bool_t SCPI_ErrorPop(scpi_t * context, scpi_error_t * error) {
     if (!error || !context) return FALSE;
+#if USE_LOCKFREE_ERROR_QUEUE
+    SCPI_ErrorSync(context);
+#endif
     SCPI_ERROR_SETVAL(error, 0, NULL);
     fifo_remove(&context->error_queue, error);
 
@@ -123,6 +127,9 @@ scpi_bool_t SCPI_ErrorPop(scpi_t * context, scpi_error_t * error) {
 int32_t SCPI_ErrorCount(scpi_t * context) {
     int16_t result = 0;
 
+#if USE_LOCKFREE_ERROR_QUEUE
+    SCPI_ErrorSync(context);
+#endif
     fifo_count(&context->error_queue, &result);
 
     return result;
@@ -138,6 +145,18 @@ static scpi_bool_t SCPI_ErrorAddInternal(scpi_t * context, int16_t err, char * i
         info_ptr = SCPIDEFINE_strndup(&context->error_info_heap, info, info_len);
     }
     SCPI_ERROR_SETVAL(&error_value, err, info_ptr);
+#if USE_LOCKFREE_ERROR_QUEUE
+    {
+        /* other threads can add errors, so the last one is not replaced */
+        scpi_error_t overflow_value;
+        SCPI_ERROR_SETVAL(&overflow_value, SCPI_ERROR_QUEUE_OVERFLOW, NULL);
+        if (!fifo_add_last(&context->error_queue, &error_value, &overflow_value)) {
+            SCPIDEFINE_free(&context->error_info_heap, error_value.device_dependent_info, true);
+            return FALSE;
+        }
+        return TRUE;
+    }
+#endif
     if (!fifo_add(&context->error_queue, &error_value)) {
         SCPIDEFINE_free(&context->error_info_heap, error_value.device_dependent_info, true);
         fifo_remove_last(&context->error_queue, &error_value);
@@ -169,6 +188,24 @@ static const struct error_reg errs[ERROR_DEFS_N] = {
     {-800, -899, ESR_OPC}, /* Operation Complete Event -800, -899 ch 21.8.16 */
 };
 
+/**
+ * Event status bits of error
+ * @param err - error number
+ * @return ESR bits
+ */
+static scpi_reg_val_t SCPI_ErrorEsrBits(int16_t err) {
+    scpi_reg_val_t result = 0;
+    int i;
+
+    for (i = 0; i < ERROR_DEFS_N; i++) {
+        if ((err <= errs[i].from) && (err >= errs[i].to)) {
+            result |= errs[i].esrBit;
+        }
+    }
+
+    return result;
+}
+
 /**
  * Push error to queue
  * @param context
@@ -177,17 +214,16 @@ static const struct error_reg errs[ERROR_DEFS_N] = {
  * @param info_len - length of text or 0 for automatic length
  */
 void SCPI_ErrorPushEx(scpi_t * context, int16_t err, char * info, size_t info_len) {
-    int i;
+    scpi_reg_val_t esr;
     /* automatic calculation of length */
     if (info && info_len == 0) {
         info_len = SCPIDEFINE_strnlen(info, SCPI_STD_ERROR_DESC_MAX_STRING_LENGTH);
     }
     scpi_bool_t queue_overflow = !SCPI_ErrorAddInternal(context, err, info, info_len);
 
-    for (i = 0; i < ERROR_DEFS_N; i++) {
-        if ((err <= errs[i].from) && (err >= errs[i].to)) {
-            SCPI_RegSetBits(context, SCPI_REG_ESR, errs[i].esrBit);
-        }
+    esr = SCPI_ErrorEsrBits(err);
+    if (esr) {
+        SCPI_RegSetBits(context, SCPI_REG_ESR, esr);
     }
 
     SCPI_ErrorEmit(context, err);
@@ -210,6 +246,53 @@ void SCPI_ErrorPush(scpi_t * context, int16_t err) {
     return;
 }
 
+#if USE_LOCKFREE_ERROR_QUEUE
+/* posted error waits for SCPI_ErrorSync, ESR bits are below */
+#define SCPI_ERROR_POSTED 0x10000UL
+
+/**
+ * Push error to queue from other thread or interrupt handler without
+ * locking. Only the queue is changed here, status bits are updated by
+ * SCPI_ErrorSync in parser thread and error callback is not called.
+ * @param context - scpi context
+ * @param err - error number
+ */
+void SCPI_ErrorPost(scpi_t * context, int16_t err) {
+    scpi_error_t error_value;
+    scpi_error_t overflow_value;
+    uint32_t esr;
+
+    SCPI_ERROR_SETVAL(&error_value, err, NULL);
+    SCPI_ERROR_SETVAL(&overflow_value, SCPI_ERROR_QUEUE_OVERFLOW, NULL);
+
+    esr = SCPI_ErrorEsrBits(err);
+    if (!fifo_add_last(&context->error_queue, &error_value, &overflow_value)) {
+        esr |= SCPI_ErrorEsrBits(SCPI_ERROR_QUEUE_OVERFLOW);
+    }
+
+    SCPIDEFINE_atomic_or(&context->error_posted, esr | SCPI_ERROR_POSTED);
+}
+
+/**
+ * Update ESR and QMA by errors posted from other threads. It is called by
+ * SCPI_Input and by error queue reading, application can call it to get
+ * service request earlier.
+ * @param context - scpi context
+ */
+void SCPI_ErrorSync(scpi_t * context) {
+    uint32_t posted = SCPIDEFINE_atomic_exchange(&context->error_posted, 0);
+
+    if (posted == 0) {
+        return;
+    }
+
+    if (posted & ~SCPI_ERROR_POSTED) {
+        SCPI_RegSetBits(context, SCPI_REG_ESR, (scpi_reg_val_t) (posted & ~SCPI_ERROR_POSTED));
+    }
+    SCPI_RegSetBits(context, SCPI_REG_STB, STB_QMA);
+}
+#endif /* USE_LOCKFREE_ERROR_QUEUE */
+
 /**
  * Translate error number to string
  * @param err - error number
@@ -28,6 +28,214 @@
 
 #include "fifo_private.h"
 
+#if USE_LOCKFREE_ERROR_QUEUE
+
+/*
+ * Lock-free queue for many producers and one consumer. Producers reserve
+ * a slot by moving wr and publish the element by writing its nonzero
+ * error code. Consumer takes published elements only, clears their code
+ * and moves rd.
+ *
+ * Positions run freely and wrap only at the biggest multiple of size that
+ * fits in 32 bits. Producer preempted between reading wr and its CAS could
+ * reserve a wrong slot if wr returned to the same value meanwhile, so the
+ * period must not be short.
+ */
+
+/**
+ * Position where wr and rd wrap to zero
+ * @param fifo
+ * @return
+ */
+static uint32_t fifo_limit(const scpi_fifo_t * fifo) {
+    return (0xFFFFFFFFul / (uint32_t) fifo->size) * (uint32_t) fifo->size;
+}
+
+/**
+ * Number of reserved elements
+ * @param limit
+ * @param wr
+ * @param rd
+ * @return
+ */
+static uint32_t fifo_used(uint32_t limit, uint32_t wr, uint32_t rd) {
+    return (wr >= rd) ? (wr - rd) : (wr + (limit - rd));
+}
+
+/**
+ * Position following pos
+ * @param limit
+ * @param pos
+ * @return
+ */
+static uint32_t fifo_next(uint32_t limit, uint32_t pos) {
+    return (pos + 1 == limit) ? 0 : pos + 1;
+}
+
+/**
+ * Element at position
+ * @param fifo
+ * @param pos
+ * @return
+ */
+static scpi_error_t * fifo_slot(scpi_fifo_t * fifo, uint32_t pos) {
+    return &fifo->data[pos % (uint32_t) fifo->size];
+}
+
+/**
+ * Initialize fifo
+ * @param fifo
+ */
+void fifo_init(scpi_fifo_t * fifo, scpi_error_t * data, int16_t size) {
+    int16_t i;
+
+    fifo->wr = 0;
+    fifo->rd = 0;
+    fifo->data = data;
+    fifo->size = size;
+    for (i = 0; i < size; i++) {
+        data[i].error_code = 0;
+    }
+}
+
+/**
+ * Empty fifo, must be called by consumer
+ * @param fifo
+ */
+void fifo_clear(scpi_fifo_t * fifo) {
+    while (fifo_remove(fifo, NULL)) {
+    }
+}
+
+/**
+ * Test if fifo is empty
+ * @param fifo
+ * @return
+ */
+scpi_bool_t fifo_is_empty(scpi_fifo_t * fifo) {
+    return SCPIDEFINE_atomic_load(&fifo->wr) == SCPIDEFINE_atomic_load(&fifo->rd);
+}
+
+/**
+ * Test if fifo is full
+ * @param fifo
+ * @return
+ */
+scpi_bool_t fifo_is_full(scpi_fifo_t * fifo) {
+    uint32_t rd = SCPIDEFINE_atomic_load(&fifo->rd);
+    return fifo_used(fifo_limit(fifo), SCPIDEFINE_atomic_load(&fifo->wr), rd) >= (uint32_t) fifo->size;
+}
+
+/**
+ * Add element to fifo, last free place of fifo gets element last instead
+ * of value. It is safe to call it concurrently from more threads and
+ * interrupts. Elements with zero error code are not added.
+ * @param fifo
+ * @param value
+ * @param last - element for the last free place or NULL
+ * @return FALSE if value was not added
+ */
+scpi_bool_t fifo_add_last(scpi_fifo_t * fifo, const scpi_error_t * value, const scpi_error_t * last) {
+    const scpi_error_t * item;
+    scpi_error_t * slot;
+    uint32_t limit = fifo_limit(fifo);
+    uint32_t wr;
+    uint32_t rd;
+    uint32_t used;
+
+    if (!value || (value->error_code == 0) || (last && (last->error_code == 0))) {
+        return FALSE;
+    }
+
+    do {
+        /* rd is read first, so it can not be ahead of wr */
+        rd = SCPIDEFINE_atomic_load(&fifo->rd);
+        wr = SCPIDEFINE_atomic_load(&fifo->wr);
+        used = fifo_used(limit, wr, rd);
+        if (used >= (uint32_t) fifo->size) {
+            return FALSE;
+        }
+        item = (last && (used + 1 == (uint32_t) fifo->size)) ? last : value;
+    } while (!SCPIDEFINE_atomic_cas(&fifo->wr, &wr, fifo_next(limit, wr)));
+
+    slot = fifo_slot(fifo, wr);
+#if USE_DEVICE_DEPENDENT_ERROR_INFORMATION
+    slot->device_dependent_info = item->device_dependent_info;
+#endif
+    SCPIDEFINE_atomic_store(&slot->error_code, item->error_code);
+
+    return item == value;
+}
+
+/**
+ * Add element to fifo. If fifo is full, return FALSE.
+ * @param fifo
+ * @param value
+ * @return
+ */
+scpi_bool_t fifo_add(scpi_fifo_t * fifo, const scpi_error_t * value) {
+    return fifo_add_last(fifo, value, NULL);
+}
+
+/**
+ * Remove element form fifo, must be called by consumer
+ * @param fifo
+ * @param value
+ * @return FALSE - fifo is empty or the oldest element is not published yet
+ */
+scpi_bool_t fifo_remove(scpi_fifo_t * fifo, scpi_error_t * value) {
+    uint32_t rd = fifo->rd;
+    scpi_error_t * slot;
+    int16_t code;
+
+    if (rd == SCPIDEFINE_atomic_load(&fifo->wr)) {
+        return FALSE;
+    }
+
+    slot = fifo_slot(fifo, rd);
+    code = SCPIDEFINE_atomic_load(&slot->error_code);
+    if (code == 0) {
+        return FALSE;
+    }
+
+    if (value) {
+        *value = *slot;
+        value->error_code = code;
+    }
+
+    slot->error_code = 0;
+    SCPIDEFINE_atomic_store(&fifo->rd, fifo_next(fifo_limit(fifo), rd));
+
+    return TRUE;
+}
+
+/**
+ * Remove last element from fifo. It is not possible while other threads
+ * can add elements.
+ * @param fifo
+ * @param value
+ * @return FALSE
+ */
+scpi_bool_t fifo_remove_last(scpi_fifo_t * fifo, scpi_error_t * value) {
+    (void) fifo;
+    (void) value;
+    return FALSE;
+}
+
+/**
+ * Retrive number of elements in fifo
+ * @param fifo
+ * @param value
+ * @return
+ */
+scpi_bool_t fifo_count(scpi_fifo_t * fifo, int16_t * value) {
+    uint32_t rd = SCPIDEFINE_atomic_load(&fifo->rd);
+    *value = (int16_t) fifo_used(fifo_limit(fifo), SCPIDEFINE_atomic_load(&fifo->wr), rd);
+    return TRUE;
+}
+
+#else /* USE_LOCKFREE_ERROR_QUEUE */
+
 /**
  * Initialize fifo
  * @param fifo
@@ -90,6 +298,22 @@ scpi_bool_t fifo_add(scpi_fifo_t * fifo, const scpi_error_t * value) {
     return TRUE;
 }
 
+/**
+ * Add element to fifo, last free place of fifo gets element last instead
+ * of value.
+ * @param fifo
+ * @param value
+ * @param last - element for the last free place or NULL
+ * @return FALSE if value was not added
+ */
+scpi_bool_t fifo_add_last(scpi_fifo_t * fifo, const scpi_error_t * value, const scpi_error_t * last) {
+    if (last && (fifo->count + 1 == fifo->size)) {
+        fifo_add(fifo, last);
+        return FALSE;
+    }
+    return fifo_add(fifo, value);
+}
+
 /**
  * Remove element form fifo
  * @param fifo
@@ -144,3 +368,5 @@ scpi_bool_t fifo_count(scpi_fifo_t * fifo, int16_t * value) {
     *value = fifo->count;
     return TRUE;
 }
+
+#endif /* USE_LOCKFREE_ERROR_QUEUE */
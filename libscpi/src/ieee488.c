@@ -113,18 +113,85 @@ static const scpi_reg_group_info_t scpi_reg_group_details[SCPI_REG_GROUP_COUNT]
 };
 
 /**
- * Get register value
+ * Get stored register value without sampling conditions
+ * @param name - register name
+ * @return register value
+ */
+static scpi_reg_val_t regValue(scpi_t * context, scpi_reg_name_t name) {
+    if (name < SCPI_REG_COUNT) {
+        return context->registers[name];
+    } else {
+        return 0;
+    }
+}
+
+#if USE_REGISTER_CONDITION_SOURCE
+/**
+ * Sample condition register of the group and of all groups summarized
+ * into it from condition sources
+ * @param context
+ * @param group - register group
+ */
+static void regSampleGroup(scpi_t * context, scpi_reg_group_t group) {
+    const scpi_reg_group_info_t * info = &scpi_reg_group_details[group];
+    int i;
+
+    for (i = 0; i < SCPI_REG_GROUP_COUNT; i++) {
+        scpi_reg_name_t parent = scpi_reg_group_details[i].parent_reg;
+        if ((i != (int) group) && (parent != SCPI_REG_NONE)
+                && ((parent == info->event) || (parent == info->condition))) {
+            regSampleGroup(context, (scpi_reg_group_t) i);
+        }
+    }
+
+    if ((info->condition != SCPI_REG_NONE) && context->reg_condition[group]) {
+        SCPI_RegSet(context, info->condition, context->reg_condition[group](context, group));
+    }
+}
+#endif
+
+/**
+ * Get register value. Condition, event and status byte registers are
+ * updated from condition sources first.
  * @param name - register name
  * @return register value
  */
 scpi_reg_val_t SCPI_RegGet(scpi_t * context, scpi_reg_name_t name) {
     if ((name < SCPI_REG_COUNT) && context) {
+#if USE_REGISTER_CONDITION_SOURCE
+        switch (scpi_reg_details[name].type) {
+            case SCPI_REG_CLASS_STB:
+            case SCPI_REG_CLASS_EVEN:
+            case SCPI_REG_CLASS_COND:
+                regSampleGroup(context, scpi_reg_details[name].group);
+                break;
+            default:
+                break;
+        }
+#endif
         return context->registers[name];
     } else {
         return 0;
     }
 }
 
+#if USE_REGISTER_CONDITION_SOURCE
+/**
+ * Set condition source of register group. Condition register is then
+ * sampled when it, its event register or status byte is read, and
+ * transitions are evaluated at that time. SCPI_RegSet on the condition
+ * register is needed only for changes, which should raise SRQ immediately.
+ * @param context
+ * @param group - register group
+ * @param source - callback returning current condition, NULL to disable
+ */
+void SCPI_RegConditionSource(scpi_t * context, scpi_reg_group_t group, scpi_reg_condition_t source) {
+    if (context && (group < SCPI_REG_GROUP_COUNT)) {
+        context->reg_condition[group] = source;
+    }
+}
+#endif
+
 /**
  * Wrapper function to control interface from context
  * @param context
@@ -151,6 +218,17 @@ void SCPI_RegSet(scpi_t * context, scpi_reg_name_t name, scpi_reg_val_t val) {
 
     scpi_reg_group_info_t register_group;
 
+#if USE_REGISTER_TRANSACTIONS
+    if (context->reg_transaction > 0) {
+        if (!context->reg_changed[name]) {
+            context->reg_old[name] = context->registers[name];
+            context->reg_changed[name] = TRUE;
+        }
+        context->registers[name] = val;
+        return;
+    }
+#endif
+
     do {
         scpi_reg_class_t register_type = scpi_reg_details[name].type;
         register_group = scpi_reg_group_details[scpi_reg_details[name].group];
@@ -177,7 +255,15 @@ void SCPI_RegSet(scpi_t * context, scpi_reg_name_t name, scpi_reg_val_t val) {
                     ptrans = ((old_val ^ val) & val);
                     context->registers[SCPI_REG_STB] |= STB_SRQ;
                     if (ptrans & val) {
+#if USE_REGISTER_TRANSACTIONS
+                        if (context->srq_deferred) {
+                            context->srq_pending = TRUE;
+                        } else {
+                            writeControl(context, SCPI_CTRL_SRQ, context->registers[SCPI_REG_STB]);
+                        }
+#else
                         writeControl(context, SCPI_CTRL_SRQ, context->registers[SCPI_REG_STB]);
+#endif
                     }
                 } else {
                     context->registers[SCPI_REG_STB] &= ~STB_SRQ;
@@ -188,7 +274,7 @@ void SCPI_RegSet(scpi_t * context, scpi_reg_name_t name, scpi_reg_val_t val) {
             {
                 scpi_reg_val_t enable;
                 if(register_group.enable != SCPI_REG_NONE) {
-                    enable = SCPI_RegGet(context, register_group.enable);
+                    enable = regValue(context, register_group.enable);
                 } else {
                     enable = 0xFFFF;
                 }
@@ -196,7 +282,7 @@ void SCPI_RegSet(scpi_t * context, scpi_reg_name_t name, scpi_reg_val_t val) {
                 scpi_bool_t summary = val & enable;
 
                 name = register_group.parent_reg;
-                val = SCPI_RegGet(context, register_group.parent_reg);
+                val = regValue(context, register_group.parent_reg);
                 if (summary) {
                     val |= register_group.parent_bit;
                 } else {
@@ -209,25 +295,25 @@ void SCPI_RegSet(scpi_t * context, scpi_reg_name_t name, scpi_reg_val_t val) {
                 name = register_group.event;
 
                 if(register_group.ptfilt == SCPI_REG_NONE && register_group.ntfilt == SCPI_REG_NONE) {
-                    val = ((old_val ^ val) & val) | SCPI_RegGet(context, register_group.event);
+                    val = ((old_val ^ val) & val) | regValue(context, register_group.event);
                 } else {
                     scpi_reg_val_t ptfilt = 0, ntfilt = 0;
                     scpi_reg_val_t transitions;
                     scpi_reg_val_t ntrans;
 
                     if(register_group.ptfilt != SCPI_REG_NONE) {
-                        ptfilt = SCPI_RegGet(context, register_group.ptfilt);
+                        ptfilt = regValue(context, register_group.ptfilt);
                     }
 
                     if(register_group.ntfilt != SCPI_REG_NONE) {
-                        ntfilt = SCPI_RegGet(context, register_group.ntfilt);
+                        ntfilt = regValue(context, register_group.ntfilt);
                     }
 
                     transitions = old_val ^ val;
                     ptrans = transitions & val;
                     ntrans = transitions & ~ptrans;
 
-                    val = ((ptrans & ptfilt) | (ntrans & ntfilt)) | SCPI_RegGet(context, register_group.event);
+                    val = ((ptrans & ptfilt) | (ntrans & ntfilt)) | regValue(context, register_group.event);
                 }
                 break;
             }
@@ -240,22 +326,209 @@ void SCPI_RegSet(scpi_t * context, scpi_reg_name_t name, scpi_reg_val_t val) {
 }
 
 /**
- * Set register bits
+ * Set register bits, condition sources are not sampled
  * @param name - register name
  * @param bits bit mask
  */
 void SCPI_RegSetBits(scpi_t * context, scpi_reg_name_t name, scpi_reg_val_t bits) {
-    SCPI_RegSet(context, name, SCPI_RegGet(context, name) | bits);
+    if (context) {
+        SCPI_RegSet(context, name, regValue(context, name) | bits);
+    }
 }
 
 /**
- * Clear register bits
+ * Clear register bits, condition sources are not sampled
  * @param name - register name
  * @param bits bit mask
  */
 void SCPI_RegClearBits(scpi_t * context, scpi_reg_name_t name, scpi_reg_val_t bits) {
-    SCPI_RegSet(context, name, SCPI_RegGet(context, name) & ~bits);
+    if (context) {
+        SCPI_RegSet(context, name, regValue(context, name) & ~bits);
+    }
+}
+
+#if USE_REGISTER_TRANSACTIONS
+/**
+ * Begin register transaction. Register changes are only collected until
+ * SCPI_RegCommit. Transactions can be nested.
+ * @param context
+ */
+void SCPI_RegBegin(scpi_t * context) {
+    if (context) {
+        context->reg_transaction++;
+    }
+}
+
+/**
+ * Order of register in transaction replay. Groups summarized into other
+ * groups follow them, so bits propagated to a parent register are not
+ * overwritten by its own replay. Condition registers are replayed after all
+ * event, enable and filter registers, they propagate into those.
+ * @param name - register name
+ * @return order, lower first
+ */
+static int regReplayOrder(scpi_reg_name_t name) {
+    scpi_reg_group_t group = scpi_reg_details[name].group;
+    scpi_reg_name_t parent = scpi_reg_group_details[group].parent_reg;
+    int order = 0;
+
+    while ((parent < SCPI_REG_COUNT) && (order < SCPI_REG_GROUP_COUNT)) {
+        order++;
+        parent = scpi_reg_group_details[scpi_reg_details[parent].group].parent_reg;
+    }
+
+    if (scpi_reg_details[name].type == SCPI_REG_CLASS_COND) {
+        order += SCPI_REG_GROUP_COUNT + 1;
+    }
+    return order;
+}
+
+/**
+ * Commit register transaction. Transitions of each changed register are
+ * evaluated once against its value before the transaction, events are
+ * propagated to STB and SRQ is signalled at most once.
+ * @param context
+ */
+void SCPI_RegCommit(scpi_t * context) {
+    int order;
+    int i;
+
+    if (!context || (context->reg_transaction <= 0) || (--context->reg_transaction > 0)) {
+        return;
+    }
+
+    /* SRQ may be already pending from changes done before with SRQ deferred */
+    context->srq_deferred = TRUE;
+    for (order = 0; order <= 2 * SCPI_REG_GROUP_COUNT + 1; order++) {
+        for (i = 0; i < SCPI_REG_COUNT; i++) {
+            if (context->reg_changed[i] && (regReplayOrder((scpi_reg_name_t) i) == order)) {
+                scpi_reg_val_t val = context->registers[i];
+                context->reg_changed[i] = FALSE;
+                context->registers[i] = context->reg_old[i];
+                SCPI_RegSet(context, (scpi_reg_name_t) i, val);
+            }
+        }
+    }
+    context->srq_deferred = FALSE;
+
+    if (context->srq_pending) {
+        context->srq_pending = FALSE;
+        writeControl(context, SCPI_CTRL_SRQ, context->registers[SCPI_REG_STB]);
+    }
+}
+#endif /* USE_REGISTER_TRANSACTIONS */
+
+#if USE_ATOMIC_REGISTERS
+/**
+ * Publish register bit change. Each half of the register has its own word
+ * with bytes of bits to set, bits to clear and bits posted with both
+ * levels since last sync, so short pulses are not lost.
+ * @param context
+ * @param name - register name
+ * @param set - bits to set
+ * @param clear - bits to clear
+ */
+static void regPost(scpi_t * context, scpi_reg_name_t name, scpi_reg_val_t set, scpi_reg_val_t clear) {
+    uint32_t posted;
+    uint32_t update;
+    uint32_t s;
+    uint32_t c;
+    int half;
+
+    if ((name >= SCPI_REG_COUNT) || (context == NULL)) {
+        return;
+    }
+
+    for (half = 0; half < 2; half++) {
+        s = (set >> (8 * half)) & 0xFF;
+        c = (clear >> (8 * half)) & 0xFF;
+        if (!(s | c)) {
+            continue;
+        }
+
+        posted = SCPIDEFINE_atomic_load(&context->registers_posted[name][half]);
+        do {
+            /* bits posted with the other level before make a pulse */
+            update = posted & ~((s << 8) | c);
+            update |= (c << 8) | s | ((((posted >> 8) & s) | (posted & c)) << 16);
+        } while (!SCPIDEFINE_atomic_cas(&context->registers_posted[name][half], &posted, update));
+    }
+
+    SCPIDEFINE_atomic_store(&context->registers_dirty, 1);
+}
+
+/**
+ * Set register bits from other thread or interrupt handler without locking.
+ * Register is changed later by SCPI_RegSync in parser thread.
+ * @param name - register name
+ * @param bits bit mask
+ */
+void SCPI_RegPostBits(scpi_t * context, scpi_reg_name_t name, scpi_reg_val_t bits) {
+    regPost(context, name, bits, 0);
+}
+
+/**
+ * Clear register bits from other thread or interrupt handler without locking.
+ * Register is changed later by SCPI_RegSync in parser thread.
+ * @param name - register name
+ * @param bits bit mask
+ */
+void SCPI_RegPostClearBits(scpi_t * context, scpi_reg_name_t name, scpi_reg_val_t bits) {
+    regPost(context, name, 0, bits);
+}
+
+/**
+ * Apply posted register bits. Events are propagated to STB and SRQ is
+ * signalled at most once for all changes. Bits posted with both levels are
+ * first set to the other level than the last posted one, so both edges are
+ * evaluated. It is called by SCPI_Input, application can call it to get SRQ
+ * without waiting for next command.
+ * @param context
+ */
+void SCPI_RegSync(scpi_t * context) {
+    scpi_reg_val_t set[SCPI_REG_COUNT];
+    scpi_reg_val_t clear[SCPI_REG_COUNT];
+    scpi_reg_val_t pulse[SCPI_REG_COUNT];
+    uint32_t posted;
+    int half;
+    int i;
+
+    if (!context || !SCPIDEFINE_atomic_exchange(&context->registers_dirty, 0)) {
+        return;
+    }
+
+    for (i = 0; i < SCPI_REG_COUNT; i++) {
+        set[i] = 0;
+        clear[i] = 0;
+        pulse[i] = 0;
+        for (half = 0; half < 2; half++) {
+            posted = SCPIDEFINE_atomic_exchange(&context->registers_posted[i][half], 0);
+            set[i] |= (scpi_reg_val_t) ((posted & 0xFF) << (8 * half));
+            clear[i] |= (scpi_reg_val_t) (((posted >> 8) & 0xFF) << (8 * half));
+            pulse[i] |= (scpi_reg_val_t) (((posted >> 16) & 0xFF) << (8 * half));
+        }
+    }
+
+    /* first edges of pulses, SRQ is signalled by the commit below */
+    if (context->reg_transaction == 0) {
+        context->srq_deferred = TRUE;
+    }
+    for (i = 0; i < SCPI_REG_COUNT; i++) {
+        if (pulse[i]) {
+            SCPI_RegSet(context, (scpi_reg_name_t) i,
+                    (context->registers[i] & ~(pulse[i] & set[i])) | (pulse[i] & clear[i]));
+        }
+    }
+
+    SCPI_RegBegin(context);
+    for (i = 0; i < SCPI_REG_COUNT; i++) {
+        if (set[i] | clear[i]) {
+            SCPI_RegSet(context, (scpi_reg_name_t) i, (context->registers[i] & ~clear[i]) | set[i]);
+        }
+    }
+    SCPI_RegCommit(context);
 }
+#endif /* USE_ATOMIC_REGISTERS */
 
 /**
  * *CLS - This command clears all status data structures in a device. 
@@ -324,8 +597,8 @@ scpi_result_t SCPI_CoreEsrQ(scpi_t * context) {
 scpi_result_t SCPI_CoreIdnQ(scpi_t * context) {
     int i;
     for (i = 0; i < 4; i++) {
-        if (context->idn[i]) {
-            SCPI_ResultMnemonic(context, context->idn[i]);
+        if (context->definition->idn[i]) {
+            SCPI_ResultMnemonic(context, context->definition->idn[i]);
         } else {
             SCPI_ResultMnemonic(context, "0");
         }
@@ -35,47 +35,239 @@
  * 
  */
 
-#include <ctype.h>
 #include <stdio.h>
 #include <string.h>
 
 #include "lexer_private.h"
 #include "scpi/error.h"
 
+#if HAVE_AVX2
+#include <immintrin.h>
+#elif HAVE_SSE2
+#include <emmintrin.h>
+#elif HAVE_NEON
+#include <arm_neon.h>
+#endif
+
+/* Classes of characters used in the table below */
+#define CC_OTHER    SCPI_CHAR_STRING                                    /* other 7 bit ASCII, only in string data */
+#define CC_TAB      (CC_OTHER | SCPI_CHAR_WS)                           /* tab */
+#define CC_TERM     (CC_OTHER | SCPI_CHAR_TERMINATOR)                   /* CR and LF */
+#define CC_QUOTE    (CC_OTHER | SCPI_CHAR_QUOTE)                        /* quotes */
+#define CC_PUNCT    (CC_OTHER | SCPI_CHAR_EXPRESSION)                   /* punctuation allowed in expression */
+#define CC_SPACE    (CC_PUNCT | SCPI_CHAR_WS)                           /* space */
+#define CC_SIGN     (CC_PUNCT | SCPI_CHAR_SIGN)                         /* plus and minus */
+#define CC_QUERY    (CC_PUNCT | SCPI_CHAR_HEADER)                       /* question mark */
+#define CC_HSTART   (CC_QUERY | SCPI_CHAR_HEADER_START)                 /* colon and star */
+#define CC_USCORE   (CC_QUERY | SCPI_CHAR_MNEMONIC)                     /* underscore */
+#define CC_DEC      (CC_USCORE | SCPI_CHAR_DIGIT | SCPI_CHAR_XDIGIT)    /* digits 8 and 9 */
+#define CC_OCT      (CC_DEC | SCPI_CHAR_OCTDIGIT)                       /* digits 2 to 7 */
+#define CC_BIN      (CC_OCT | SCPI_CHAR_BINDIGIT)                       /* digits 0 and 1 */
+#define CC_ALPHA    (CC_HSTART | SCPI_CHAR_MNEMONIC | SCPI_CHAR_ALPHA)  /* letters */
+#define CC_HEX      (CC_ALPHA | SCPI_CHAR_XDIGIT)                       /* letters A to F */
+#define CC_EXP      (CC_HEX | SCPI_CHAR_EXPONENT)                       /* letter E */
+
+/**
+ * Classes of all characters, independent of C locale
+ */
+const uint16_t scpiLex_CharClass[256] = {
+    CC_OTHER,  CC_OTHER,  CC_OTHER,  CC_OTHER,  CC_OTHER,  CC_OTHER,  CC_OTHER,  CC_OTHER,  /* 0x00 */
+    CC_OTHER,  CC_TAB,    CC_TERM,   CC_OTHER,  CC_OTHER,  CC_TERM,   CC_OTHER,  CC_OTHER,  /* 0x08 */
+    CC_OTHER,  CC_OTHER,  CC_OTHER,  CC_OTHER,  CC_OTHER,  CC_OTHER,  CC_OTHER,  CC_OTHER,  /* 0x10 */
+    CC_OTHER,  CC_OTHER,  CC_OTHER,  CC_OTHER,  CC_OTHER,  CC_OTHER,  CC_OTHER,  CC_OTHER,  /* 0x18 */
+    CC_SPACE,  CC_PUNCT,  CC_QUOTE,  CC_OTHER,  CC_PUNCT,  CC_PUNCT,  CC_PUNCT,  CC_QUOTE,  /* 0x20 */
+    CC_OTHER,  CC_OTHER,  CC_HSTART, CC_SIGN,   CC_PUNCT,  CC_SIGN,   CC_PUNCT,  CC_PUNCT,  /* 0x28 */
+    CC_BIN,    CC_BIN,    CC_OCT,    CC_OCT,    CC_OCT,    CC_OCT,    CC_OCT,    CC_OCT,    /* 0x30 */
+    CC_DEC,    CC_DEC,    CC_HSTART, CC_OTHER,  CC_PUNCT,  CC_PUNCT,  CC_PUNCT,  CC_QUERY,  /* 0x38 */
+    CC_PUNCT,  CC_HEX,    CC_HEX,    CC_HEX,    CC_HEX,    CC_EXP,    CC_HEX,    CC_ALPHA,  /* 0x40 */
+    CC_ALPHA,  CC_ALPHA,  CC_ALPHA,  CC_ALPHA,  CC_ALPHA,  CC_ALPHA,  CC_ALPHA,  CC_ALPHA,  /* 0x48 */
+    CC_ALPHA,  CC_ALPHA,  CC_ALPHA,  CC_ALPHA,  CC_ALPHA,  CC_ALPHA,  CC_ALPHA,  CC_ALPHA,  /* 0x50 */
+    CC_ALPHA,  CC_ALPHA,  CC_ALPHA,  CC_PUNCT,  CC_PUNCT,  CC_PUNCT,  CC_PUNCT,  CC_USCORE, /* 0x58 */
+    CC_PUNCT,  CC_HEX,    CC_HEX,    CC_HEX,    CC_HEX,    CC_EXP,    CC_HEX,    CC_ALPHA,  /* 0x60 */
+    CC_ALPHA,  CC_ALPHA,  CC_ALPHA,  CC_ALPHA,  CC_ALPHA,  CC_ALPHA,  CC_ALPHA,  CC_ALPHA,  /* 0x68 */
+    CC_ALPHA,  CC_ALPHA,  CC_ALPHA,  CC_ALPHA,  CC_ALPHA,  CC_ALPHA,  CC_ALPHA,  CC_ALPHA,  /* 0x70 */
+    CC_ALPHA,  CC_ALPHA,  CC_ALPHA,  CC_PUNCT,  CC_PUNCT,  CC_PUNCT,  CC_PUNCT,  CC_OTHER,  /* 0x78 */
+    /* 0x80 - 0xff are zero, not allowed anywhere */
+};
+
 /**
- * Is white space
+ * Is character of given class
  * @param c
+ * @param cls - SCPI_CHAR_* flags
  * @return 
  */
-static int isws(int c) {
-    if ((c == ' ') || (c == '\t')) {
-        return 1;
+static int isclass(int c, uint16_t cls) {
+    return scpiLex_IsCharClass(c, cls);
+}
+
+/* Vector operations for scanning of long strings, masks are bitmaps of bytes */
+#if HAVE_AVX2
+#define LEX_VECTOR_SIZE 32
+#define LEX_MASK_BITS 1
+typedef __m256i lex_vector_t;
+#define vecLoad(p) _mm256_loadu_si256((const __m256i *) (p))
+#define vecSet(c) _mm256_set1_epi8((char) (c))
+#define vecEq(a, b) _mm256_cmpeq_epi8((a), (b))
+#define vecOr(a, b) _mm256_or_si256((a), (b))
+#define vecNot(a) _mm256_xor_si256((a), _mm256_set1_epi8(-1))
+#define vecNonAscii(a) _mm256_cmpgt_epi8(_mm256_setzero_si256(), (a))
+#define vecRange(a, lo, hi) _mm256_and_si256(_mm256_cmpgt_epi8((a), vecSet((lo) - 1)), _mm256_cmpgt_epi8(vecSet((hi) + 1), (a)))
+#define vecMask(a) ((uint64_t) (uint32_t) _mm256_movemask_epi8(a))
+#elif HAVE_SSE2
+#define LEX_VECTOR_SIZE 16
+#define LEX_MASK_BITS 1
+typedef __m128i lex_vector_t;
+#define vecLoad(p) _mm_loadu_si128((const __m128i *) (p))
+#define vecSet(c) _mm_set1_epi8((char) (c))
+#define vecEq(a, b) _mm_cmpeq_epi8((a), (b))
+#define vecOr(a, b) _mm_or_si128((a), (b))
+#define vecNot(a) _mm_xor_si128((a), _mm_set1_epi8(-1))
+#define vecNonAscii(a) _mm_cmpgt_epi8(_mm_setzero_si128(), (a))
+#define vecRange(a, lo, hi) _mm_and_si128(_mm_cmpgt_epi8((a), vecSet((lo) - 1)), _mm_cmpgt_epi8(vecSet((hi) + 1), (a)))
+#define vecMask(a) ((uint64_t) (uint32_t) _mm_movemask_epi8(a))
+#elif HAVE_NEON
+#define LEX_VECTOR_SIZE 16
+#define LEX_MASK_BITS 4
+typedef uint8x16_t lex_vector_t;
+#define vecLoad(p) vld1q_u8((const uint8_t *) (p))
+#define vecSet(c) vdupq_n_u8((uint8_t) (c))
+#define vecEq(a, b) vceqq_u8((a), (b))
+#define vecOr(a, b) vorrq_u8((a), (b))
+#define vecNot(a) vmvnq_u8(a)
+#define vecNonAscii(a) vcgeq_u8((a), vdupq_n_u8(0x80))
+#define vecRange(a, lo, hi) vandq_u8(vcgeq_u8((a), vecSet(lo)), vcleq_u8((a), vecSet(hi)))
+#define vecMask(a) vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(a), 4)), 0)
+#endif
+
+#ifdef LEX_VECTOR_SIZE
+/* index of first byte marked in non zero mask */
+#define maskFirst(mask) ((size_t) __builtin_ctzll(mask) / LEX_MASK_BITS)
+#endif
+
+/**
+ * Length of string program data up to the quote character or character
+ * which is not 7 bit ASCII
+ * @param data
+ * @param len
+ * @param quote
+ * @return 
+ */
+size_t scpiLex_SpanString(const char * data, size_t len, char quote) {
+    size_t i = 0;
+#ifdef LEX_VECTOR_SIZE
+    lex_vector_t q = vecSet(quote);
+    lex_vector_t v;
+    uint64_t mask;
+
+    for (; i + LEX_VECTOR_SIZE <= len; i += LEX_VECTOR_SIZE) {
+        v = vecLoad(data + i);
+        mask = vecMask(vecOr(vecEq(v, q), vecNonAscii(v)));
+        if (mask) {
+            return i + maskFirst(mask);
+        }
     }
-    return 0;
+#endif
+    while ((i < len) && isclass(data[i], SCPI_CHAR_STRING) && (data[i] != quote)) {
+        i++;
+    }
+    return i;
 }
 
 /**
- * Is binary digit
- * @param c
+ * Length of string program data up to the quote character, terminator or
+ * character which is not 7 bit ASCII
+ * @param data
+ * @param len
+ * @param quote
  * @return 
  */
-static int isbdigit(int c) {
-    if ((c == '0') || (c == '1')) {
-        return 1;
+size_t scpiLex_SpanStringLine(const char * data, size_t len, char quote) {
+    size_t i = 0;
+#ifdef LEX_VECTOR_SIZE
+    lex_vector_t q = vecSet(quote);
+    lex_vector_t v;
+    lex_vector_t stop;
+    uint64_t mask;
+
+    for (; i + LEX_VECTOR_SIZE <= len; i += LEX_VECTOR_SIZE) {
+        v = vecLoad(data + i);
+        stop = vecOr(vecEq(v, q), vecNonAscii(v));
+        stop = vecOr(stop, vecOr(vecEq(v, vecSet('\r')), vecEq(v, vecSet('\n'))));
+        mask = vecMask(stop);
+        if (mask) {
+            return i + maskFirst(mask);
+        }
     }
-    return 0;
+#endif
+    while ((i < len) && isclass(data[i], SCPI_CHAR_STRING) && !isclass(data[i], SCPI_CHAR_TERMINATOR)
+            && (data[i] != quote)) {
+        i++;
+    }
+    return i;
 }
 
 /**
- * Is hexadecimal digit
- * @param c
+ * Length of characters allowed inside of expression program data
+ * @param data
+ * @param len
  * @return 
  */
-static int isqdigit(int c) {
-    if ((c == '0') || (c == '1') || (c == '2') || (c == '3') || (c == '4') || (c == '5') || (c == '6') || (c == '7')) {
-        return 1;
+size_t scpiLex_SpanExpression(const char * data, size_t len) {
+    size_t i = 0;
+#ifdef LEX_VECTOR_SIZE
+    lex_vector_t v;
+    lex_vector_t stop;
+    uint64_t mask;
+
+    for (; i + LEX_VECTOR_SIZE <= len; i += LEX_VECTOR_SIZE) {
+        v = vecLoad(data + i);
+        stop = vecNot(vecRange(v, 0x20, 0x7e));
+        stop = vecOr(stop, vecOr(vecEq(v, vecSet('"')), vecEq(v, vecSet('#'))));
+        stop = vecOr(stop, vecOr(vecEq(v, vecSet('\'')), vecEq(v, vecSet(';'))));
+        stop = vecOr(stop, vecOr(vecEq(v, vecSet('(')), vecEq(v, vecSet(')'))));
+        mask = vecMask(stop);
+        if (mask) {
+            return i + maskFirst(mask);
+        }
     }
-    return 0;
+#endif
+    while ((i < len) && isclass(data[i], SCPI_CHAR_EXPRESSION)) {
+        i++;
+    }
+    return i;
+}
+
+/**
+ * Length of parameter data up to a character which can change state of
+ * input scanner: terminator, separator or start of program header
+ * @param data
+ * @param len
+ * @return 
+ */
+size_t scpiLex_SpanData(const char * data, size_t len) {
+    size_t i = 0;
+#ifdef LEX_VECTOR_SIZE
+    lex_vector_t v;
+    lex_vector_t stop;
+    uint64_t mask;
+
+    for (; i + LEX_VECTOR_SIZE <= len; i += LEX_VECTOR_SIZE) {
+        v = vecLoad(data + i);
+        stop = vecRange(vecOr(v, vecSet(0x20)), 'a', 'z');
+        stop = vecOr(stop, vecOr(vecEq(v, vecSet('\r')), vecEq(v, vecSet('\n'))));
+        stop = vecOr(stop, vecOr(vecEq(v, vecSet(',')), vecEq(v, vecSet(';'))));
+        stop = vecOr(stop, vecOr(vecEq(v, vecSet(':')), vecEq(v, vecSet('*'))));
+        mask = vecMask(stop);
+        if (mask) {
+            return i + maskFirst(mask);
+        }
+    }
+#endif
+    while ((i < len) && !isclass(data[i], SCPI_CHAR_TERMINATOR | SCPI_CHAR_HEADER_START)
+            && (data[i] != ',') && (data[i] != ';')) {
+        i++;
+    }
+    return i;
 }
 
 /**
@@ -110,15 +302,6 @@ static int ischr(lex_state_t * state, char chr) {
     return (state->pos[0] == chr);
 }
 
-/**
- * Is plus or minus
- * @param c
- * @return 
- */
-static int isplusmn(int c) {
-    return c == '+' || c == '-';
-}
-
 /**
  * Is letter H
  * @param c
@@ -146,15 +329,6 @@ static int isQ(int c) {
     return c == 'q' || c == 'Q';
 }
 
-/**
- * Is letter E
- * @param c
- * @return 
- */
-static int isE(int c) {
-    return c == 'e' || c == 'E';
-}
-
 #define SKIP_NONE       0
 #define SKIP_OK         1
 #define SKIP_INCOMPLETE -1
@@ -164,18 +338,29 @@ static int isE(int c) {
 /* TODO: static int skipProgramMessageUnitSeparator(lex_state_t * state) */
 
 /**
- * Skip all whitespaces
+ * Skip all characters of given class
  * @param state
- * @return 
+ * @param cls - SCPI_CHAR_* flags
+ * @return number of skipped characters
  */
-static int skipWs(lex_state_t * state) {
-    int someSpace = 0;
-    while (!iseos(state) && isws(state->pos[0])) {
+static int skipClass(lex_state_t * state, uint16_t cls) {
+    const char * startPos = state->pos;
+    const char * end = state->buffer + state->len;
+
+    while ((state->pos < end) && isclass(state->pos[0], cls)) {
         state->pos++;
-        someSpace++;
     }
 
-    return someSpace;
+    return state->pos - startPos;
+}
+
+/**
+ * Skip all whitespaces
+ * @param state
+ * @return 
+ */
+static int skipWs(lex_state_t * state) {
+    return skipClass(state, SCPI_CHAR_WS);
 }
 
 /* 7.4.2 <PROGRAM DATA SEPARATOR> */
@@ -190,7 +375,7 @@ static int skipWs(lex_state_t * state) {
  * @return 
  */
 static int skipDigit(lex_state_t * state) {
-    if (!iseos(state) && isdigit((uint8_t)(state->pos[0]))) {
+    if (!iseos(state) && isclass(state->pos[0], SCPI_CHAR_DIGIT)) {
         state->pos++;
         return SKIP_OK;
     } else {
@@ -198,27 +383,13 @@ static int skipDigit(lex_state_t * state) {
     }
 }
 
-/**
- * Skip multiple decimal digits
- * @param state
- * @return 
- */
-static int skipNumbers(lex_state_t * state) {
-    int someNumbers = 0;
-    while (!iseos(state) && isdigit((uint8_t)(state->pos[0]))) {
-        state->pos++;
-        someNumbers++;
-    }
-    return someNumbers;
-}
-
 /**
  * Skip plus or minus
  * @param state
  * @return 
  */
 static int skipPlusmn(lex_state_t * state) {
-    if (!iseos(state) && isplusmn(state->pos[0])) {
+    if (!iseos(state) && isclass(state->pos[0], SCPI_CHAR_SIGN)) {
         state->pos++;
         return SKIP_OK;
     } else {
@@ -232,12 +403,7 @@ static int skipPlusmn(lex_state_t * state) {
  * @return 
  */
 static int skipAlpha(lex_state_t * state) {
-    int someLetters = 0;
-    while (!iseos(state) && isalpha((uint8_t)(state->pos[0]))) {
-        state->pos++;
-        someLetters++;
-    }
-    return someLetters;
+    return skipClass(state, SCPI_CHAR_ALPHA);
 }
 
 /**
@@ -306,11 +472,9 @@ static int skipColon(lex_state_t * state) {
  */
 static int skipProgramMnemonic(lex_state_t * state) {
     const char * startPos = state->pos;
-    if (!iseos(state) && isalpha((uint8_t)(state->pos[0]))) {
+    if (!iseos(state) && isclass(state->pos[0], SCPI_CHAR_ALPHA)) {
         state->pos++;
-        while (!iseos(state) && (isalnum((uint8_t)(state->pos[0])) || ischr(state, '_'))) {
-            state->pos++;
-        }
+        skipClass(state, SCPI_CHAR_MNEMONIC);
     }
 
     if (iseos(state)) {
@@ -452,11 +616,9 @@ int scpiLex_ProgramHeader(lex_state_t * state, scpi_token_t * token) {
 int scpiLex_CharacterProgramData(lex_state_t * state, scpi_token_t * token) {
     token->ptr = state->pos;
 
-    if (!iseos(state) && isalpha((uint8_t)(state->pos[0]))) {
+    if (!iseos(state) && isclass(state->pos[0], SCPI_CHAR_ALPHA)) {
         state->pos++;
-        while (!iseos(state) && (isalnum((uint8_t)(state->pos[0])) || ischr(state, '_'))) {
-            state->pos++;
-        }
+        skipClass(state, SCPI_CHAR_MNEMONIC);
     }
 
     token->len = state->pos - token->ptr;
@@ -470,31 +632,92 @@ int scpiLex_CharacterProgramData(lex_state_t * state, scpi_token_t * token) {
 }
 
 /* 7.7.2 <DECIMAL NUMERIC PROGRAM DATA> */
-static int skipMantisa(lex_state_t * state) {
+
+/**
+ * Skip decimal digits of mantissa and accumulate their value, only first
+ * 19 significant digits fit in the mantissa
+ * @param state
+ * @param decimal
+ * @param significant - number of significant digits in mantissa
+ * @param fraction - digits are behind decimal point
+ * @return number of digits
+ */
+static int skipMantisaNumbers(lex_state_t * state, scpi_decimal_t * decimal, int * significant, scpi_bool_t fraction) {
     int someNumbers = 0;
+    int digit;
+
+    while (!iseos(state) && isclass(state->pos[0], SCPI_CHAR_DIGIT)) {
+        digit = state->pos[0] - '0';
+        if (*significant < 19) {
+            decimal->mantissa = decimal->mantissa * 10 + digit;
+            if (decimal->mantissa) {
+                (*significant)++;
+            }
+            if (fraction) {
+                decimal->exponent--;
+            }
+        } else {
+            if (!fraction) {
+                decimal->exponent++;
+            }
+            if (digit) {
+                decimal->truncated = TRUE;
+            }
+        }
+        state->pos++;
+        someNumbers++;
+    }
+    return someNumbers;
+}
+
+static int skipMantisa(lex_state_t * state, scpi_decimal_t * decimal) {
+    int someNumbers = 0;
+    int significant = 0;
+
+    decimal->mantissa = 0;
+    decimal->exponent = 0;
+    decimal->negative = !iseos(state) && ischr(state, '-');
+    decimal->truncated = FALSE;
+    decimal->integer = TRUE;
 
     skipPlusmn(state);
 
-    someNumbers += skipNumbers(state);
+    someNumbers += skipMantisaNumbers(state, decimal, &significant, FALSE);
 
     if (skipChr(state, '.')) {
-        someNumbers += skipNumbers(state);
+        decimal->integer = FALSE;
+        someNumbers += skipMantisaNumbers(state, decimal, &significant, TRUE);
     }
 
     return someNumbers;
 }
 
-static int skipExponent(lex_state_t * state) {
+static int skipExponent(lex_state_t * state, scpi_decimal_t * decimal) {
     int someNumbers = 0;
+    int32_t exponent = 0;
+    scpi_bool_t negative = FALSE;
 
-    if (!iseos(state) && isE(state->pos[0])) {
+    if (!iseos(state) && isclass(state->pos[0], SCPI_CHAR_EXPONENT)) {
         state->pos++;
 
         skipWs(state);
 
+        negative = !iseos(state) && ischr(state, '-');
         skipPlusmn(state);
 
-        someNumbers = skipNumbers(state);
+        while (!iseos(state) && isclass(state->pos[0], SCPI_CHAR_DIGIT)) {
+            /* anything bigger overflows or underflows anyway */
+            if (exponent < 100000) {
+                exponent = exponent * 10 + (state->pos[0] - '0');
+            }
+            state->pos++;
+            someNumbers++;
+        }
+
+        if (someNumbers) {
+            decimal->exponent += negative ? -exponent : exponent;
+            decimal->integer = FALSE;
+        }
     }
 
     return someNumbers;
@@ -508,12 +731,18 @@ static int skipExponent(lex_state_t * state) {
  */
 int scpiLex_DecimalNumericProgramData(lex_state_t * state, scpi_token_t * token) {
     char * rollback;
+#if USE_NUMERIC_TOKEN_VALUE
+    scpi_decimal_t * decimal = &token->decimal;
+#else
+    scpi_decimal_t unused;
+    scpi_decimal_t * decimal = &unused;
+#endif
     token->ptr = state->pos;
 
-    if (skipMantisa(state)) {
+    if (skipMantisa(state, decimal)) {
         rollback = state->pos;
         skipWs(state);
-        if (!skipExponent(state)) {
+        if (!skipExponent(state, decimal)) {
             state->pos = rollback;
         }
     } else {
@@ -523,6 +752,7 @@ int scpiLex_DecimalNumericProgramData(lex_state_t * state, scpi_token_t * token)
     token->len = state->pos - token->ptr;
     if (token->len > 0) {
         token->type = SCPI_TOKEN_DECIMAL_NUMERIC_PROGRAM_DATA;
+        decimal->suffix = token->len;
     } else {
         token->type = SCPI_TOKEN_UNKNOWN;
     }
@@ -562,30 +792,15 @@ int scpiLex_SuffixProgramData(lex_state_t * state, scpi_token_t * token) {
 
 /* 7.7.4 <NONDECIMAL NUMERIC PROGRAM DATA> */
 static int skipHexNum(lex_state_t * state) {
-    int someNumbers = 0;
-    while (!iseos(state) && isxdigit((uint8_t)(state->pos[0]))) {
-        state->pos++;
-        someNumbers++;
-    }
-    return someNumbers;
+    return skipClass(state, SCPI_CHAR_XDIGIT);
 }
 
 static int skipOctNum(lex_state_t * state) {
-    int someNumbers = 0;
-    while (!iseos(state) && isqdigit(state->pos[0])) {
-        state->pos++;
-        someNumbers++;
-    }
-    return someNumbers;
+    return skipClass(state, SCPI_CHAR_OCTDIGIT);
 }
 
 static int skipBinNum(lex_state_t * state) {
-    int someNumbers = 0;
-    while (!iseos(state) && isbdigit(state->pos[0])) {
-        state->pos++;
-        someNumbers++;
-    }
-    return someNumbers;
+    return skipClass(state, SCPI_CHAR_BINDIGIT);
 }
 
 /**
@@ -627,14 +842,11 @@ int scpiLex_NondecimalNumericData(lex_state_t * state, scpi_token_t * token) {
 }
 
 /* 7.7.5 <STRING PROGRAM DATA> */
-static int isascii7bit(int c) {
-    return (c >= 0) && (c <= 0x7f);
-}
-
 static void skipQuoteProgramData(lex_state_t * state, char quote) {
     while (!iseos(state)) {
-        if (isascii7bit(state->pos[0]) && !ischr(state, quote)) {
-            state->pos++;
+        state->pos += scpiLex_SpanString(state->pos, state->buffer + state->len - state->pos, quote);
+        if (iseos(state)) {
+            break;
         } else if (ischr(state, quote)) {
             state->pos++;
             if (!iseos(state) && ischr(state, quote)) {
@@ -705,10 +917,6 @@ int scpiLex_StringProgramData(lex_state_t * state, scpi_token_t * token) {
 }
 
 /* 7.7.6 <ARBITRARY BLOCK PROGRAM DATA> */
-static int isNonzeroDigit(int c) {
-    return isdigit(c) && (c != '0');
-}
-
 /**
  * Detect token Block Data
  * @param state
@@ -723,13 +931,13 @@ int scpiLex_ArbitraryBlockProgramData(lex_state_t * state, scpi_token_t * token)
     token->ptr = state->pos;
 
     if (skipChr(state, '#')) {
-        if (!iseos(state) && isNonzeroDigit(state->pos[0])) {
+        if (!iseos(state) && isclass(state->pos[0], SCPI_CHAR_DIGIT) && !ischr(state, '0')) {
             /* Get number of digits */
             i = state->pos[0] - '0';
             state->pos++;
 
             for (; i > 0; i--) {
-                if (!iseos(state) && isdigit((uint8_t)(state->pos[0]))) {
+                if (!iseos(state) && isclass(state->pos[0], SCPI_CHAR_DIGIT)) {
                     arbitraryBlockLength *= 10;
                     arbitraryBlockLength += (state->pos[0] - '0');
                     state->pos++;
@@ -774,25 +982,8 @@ int scpiLex_ArbitraryBlockProgramData(lex_state_t * state, scpi_token_t * token)
 }
 
 /* 7.7.7 <EXPRESSION PROGRAM DATA> */
-static int isProgramExpression(int c) {
-    if ((c >= 0x20) && (c <= 0x7e)) {
-        if ((c != '"')
-                && (c != '#')
-                && (c != '\'')
-                && (c != '(')
-                && (c != ')')
-                && (c != ';')) {
-            return 1;
-        }
-    }
-
-    return 0;
-}
-
 static void skipProgramExpression(lex_state_t * state) {
-    while (!iseos(state) && isProgramExpression(state->pos[0])) {
-        state->pos++;
-    }
+    state->pos += scpiLex_SpanExpression(state->pos, state->buffer + state->len - state->pos);
 }
 
 /* TODO: 7.7.7.2-2 recursive - any program data */
@@ -45,6 +45,32 @@
 extern "C" {
 #endif
 
+/* Character classes in scpiLex_CharClass */
+#define SCPI_CHAR_WS            0x0001 /* space or tab */
+#define SCPI_CHAR_DIGIT         0x0002
+#define SCPI_CHAR_ALPHA         0x0004
+#define SCPI_CHAR_MNEMONIC      0x0008 /* letter, digit or underscore */
+#define SCPI_CHAR_XDIGIT        0x0010
+#define SCPI_CHAR_OCTDIGIT      0x0020
+#define SCPI_CHAR_BINDIGIT      0x0040
+#define SCPI_CHAR_STRING        0x0080 /* 7 bit ASCII allowed in string data */
+#define SCPI_CHAR_EXPRESSION    0x0100 /* allowed inside of expression */
+#define SCPI_CHAR_TERMINATOR    0x0200 /* CR or LF */
+#define SCPI_CHAR_QUOTE         0x0400
+#define SCPI_CHAR_SIGN          0x0800
+#define SCPI_CHAR_EXPONENT      0x1000 /* letter E */
+#define SCPI_CHAR_HEADER_START  0x2000 /* letter, colon or star */
+#define SCPI_CHAR_HEADER        0x4000 /* mnemonic, colon, star or question mark */
+
+#define scpiLex_IsCharClass(c, cls) ((scpiLex_CharClass[(uint8_t) (c)] & (cls)) != 0)
+
+    extern const uint16_t scpiLex_CharClass[256] LOCAL;
+
+    size_t scpiLex_SpanString(const char * data, size_t len, char quote) LOCAL;
+    size_t scpiLex_SpanStringLine(const char * data, size_t len, char quote) LOCAL;
+    size_t scpiLex_SpanExpression(const char * data, size_t len) LOCAL;
+    size_t scpiLex_SpanData(const char * data, size_t len) LOCAL;
+
     int scpiLex_IsEos(lex_state_t * state) LOCAL;
     int scpiLex_WhiteSpace(lex_state_t * state, scpi_token_t * token) LOCAL;
     int scpiLex_ProgramHeader(lex_state_t * state, scpi_token_t * token) LOCAL;
@@ -35,17 +35,242 @@
  *
  */
 
-#include <ctype.h>
+#include <limits.h>
 #include <string.h>
 
 #include "scpi/config.h"
 #include "scpi/parser.h"
 #include "parser_private.h"
 #include "lexer_private.h"
+#include "dtoa_private.h"
+#include "strtod_private.h"
 #include "scpi/error.h"
+#include "scpi/ieee488.h"
 #include "scpi/constants.h"
 #include "scpi/utils.h"
 
+/* buffered data and up to three pieces of result in one writev call */
+#define SCPI_WRITE_VECTOR_MAX 4
+
+/**
+ * Hand data to the interface write
+ * @param context
+ * @param data
+ * @param len - length of data
+ * @return number of bytes accepted by the interface
+ */
+static size_t writeInterface(scpi_t * context, const char * data, size_t len) {
+    size_t written = context->interface->write(context, data, len);
+    if (written > 0) {
+        context->output_started = TRUE;
+    }
+    return written;
+}
+
+/**
+ * Remove data accepted by the interface from the output buffer
+ * @param context
+ * @param written - number of bytes accepted from the beginning of the buffer
+ */
+static void consumeOutputBuffer(scpi_t * context, size_t written) {
+    if (written >= context->output.position) {
+        context->output.position = 0;
+    } else if (written > 0) {
+        memmove(context->output.data, context->output.data + written, context->output.position - written);
+        context->output.position -= written;
+    }
+}
+
+/**
+ * Hand data collected in output buffer to the interface. Data which are not
+ * accepted stay queued at the beginning of the buffer.
+ * @param context
+ */
+static void writeOutputBuffer(scpi_t * context) {
+    if (context->output.position > 0) {
+        consumeOutputBuffer(context,
+                writeInterface(context, context->output.data, context->output.position));
+    }
+}
+
+/**
+ * Copy data to output buffer, buffer is written out whenever it gets full
+ * @param context
+ * @param data
+ * @param len - length of data to be queued
+ * @return number of bytes queued
+ */
+static size_t queueOutput(scpi_t * context, const char * data, size_t len) {
+    size_t result = 0;
+    size_t step;
+    int retry;
+
+    if (context->output_deadlocked) {
+        /* rest of the response message is discarded */
+        return 0;
+    }
+
+    for (;;) {
+        step = context->output.length - context->output.position;
+        if (step > len) {
+            step = len;
+        }
+        memcpy(context->output.data + context->output.position, data, step);
+        context->output.position += step;
+        result += step;
+        data += step;
+        len -= step;
+
+        if (len == 0) {
+            break;
+        }
+
+        /*
+         * Response can not be suspended in the middle of a command, so give
+         * the interface a few more chances to accept data
+         */
+        writeOutputBuffer(context);
+        for (retry = 0; (retry < SCPI_OUTPUT_WRITE_RETRIES)
+                && (context->output.position == context->output.length); retry++) {
+            if (context->interface->flush) {
+                context->interface->flush(context);
+            }
+            writeOutputBuffer(context);
+        }
+
+        if (context->output.position == context->output.length) {
+            /* queued data are kept for SCPI_OutputReady, IEEE 488.2 6.3.1.7 */
+            context->output_deadlocked = TRUE;
+            context->output_pending = TRUE;
+            SCPI_ErrorPush(context, SCPI_ERROR_QUERY_DEADLOCKED);
+            break;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * Write one piece of data through the output buffer
+ * @param context
+ * @param data
+ * @param len - length of data to be written
+ * @return number of bytes written
+ */
+static size_t writeBuffered(scpi_t * context, const char * data, size_t len) {
+    size_t written;
+
+    if (context->output.length == 0) {
+        return writeInterface(context, data, len);
+    }
+
+    if (len > (context->output.length - context->output.position)) {
+        writeOutputBuffer(context);
+        if ((context->output.position == 0) && (len >= context->output.length)) {
+            /* big data are not copied, only the part not accepted is queued */
+            written = writeInterface(context, data, len);
+            if (written >= len) {
+                return len;
+            }
+            return written + queueOutput(context, data + written, len - written);
+        }
+    }
+
+    return queueOutput(context, data, len);
+}
+
+/**
+ * Write several pieces of data to SCPI output
+ *
+ * Pieces are collected in output buffer when possible. Pieces too big for it
+ * are handed over together with buffered data by one writev call without
+ * copying, if the interface provides it.
+ * @param context
+ * @param iov - pieces of data
+ * @param iovcnt - number of pieces
+ * @return number of bytes written
+ */
+static size_t writeVector(scpi_t * context, const scpi_iovec_t * iov, size_t iovcnt) {
+    scpi_iovec_t vec[SCPI_WRITE_VECTOR_MAX];
+    size_t len = 0;
+    size_t buffered;
+    size_t written;
+    size_t result;
+    size_t i;
+    size_t n;
+
+#if USE_BLOCK_STREAMING
+    if (context->block_producer != NULL) {
+        /* header of produced block is written, its data must follow it */
+        SCPI_ErrorPush(context, SCPI_ERROR_QUERY_UNTERM_INDEF_RESP);
+        return 0;
+    }
+#endif
+
+    for (i = 0; i < iovcnt; i++) {
+        len += iov[i].len;
+    }
+
+    if (len == 0) {
+        return 0;
+    }
+
+    if ((context->interface->writev == NULL)
+            || (iovcnt >= SCPI_WRITE_VECTOR_MAX)
+            || (len <= (context->output.length - context->output.position))
+            || (len < context->output.length)) {
+        result = 0;
+        for (i = 0; i < iovcnt; i++) {
+            if (iov[i].len > 0) {
+                result += writeBuffered(context, iov[i].data, iov[i].len);
+            }
+        }
+        return result;
+    }
+
+    n = 0;
+    buffered = context->output.position;
+    if (buffered > 0) {
+        vec[n].data = context->output.data;
+        vec[n].len = buffered;
+        n++;
+    }
+    for (i = 0; i < iovcnt; i++) {
+        if (iov[i].len > 0) {
+            vec[n++] = iov[i];
+        }
+    }
+
+    written = context->interface->writev(context, vec, n);
+    if (written > 0) {
+        context->output_started = TRUE;
+    }
+    if ((written >= buffered + len) || (context->output.length == 0)) {
+        context->output.position = 0;
+        return (written > buffered) ? (written - buffered) : 0;
+    }
+
+    /* queue the part not accepted by the interface */
+    if (written < buffered) {
+        consumeOutputBuffer(context, written);
+        written = 0;
+    } else {
+        context->output.position = 0;
+        written -= buffered;
+    }
+
+    result = written;
+    for (i = 0; i < iovcnt; i++) {
+        if (written >= iov[i].len) {
+            written -= iov[i].len;
+        } else {
+            result += queueOutput(context, iov[i].data + written, iov[i].len - written);
+            written = 0;
+        }
+    }
+    return result;
+}
+
 /**
  * Write data to SCPI output
  * @param context
@@ -54,12 +279,70 @@
  * @return number of bytes written
  */
 static size_t writeData(scpi_t * context, const char * data, size_t len) {
-    if ((len > 0) && (data != NULL)) {
-        return context->interface->write(context, data, len);
-    } else {
+    scpi_iovec_t iov;
+
+    if ((len == 0) || (data == NULL)) {
         return 0;
     }
+
+    iov.data = data;
+    iov.len = len;
+    return writeVector(context, &iov, 1);
+}
+
+#if USE_BLOCK_STREAMING
+/**
+ * Pull arbitrary block data from producer to output buffer while the
+ * interface accepts them. Without output buffer the data are written
+ * directly. It stops when producer has no data available now.
+ * @param context
+ */
+static void produceOutput(scpi_t * context) {
+    char chunk[64];
+    char * buffer;
+    size_t max;
+    size_t len;
+
+    while (context->block_producer != NULL) {
+        if (context->output.length == 0) {
+            buffer = chunk;
+            max = sizeof (chunk);
+        } else {
+            if (context->output.position == context->output.length) {
+                writeOutputBuffer(context);
+                if (context->output.position == context->output.length) {
+                    return;
+                }
+            }
+            buffer = context->output.data + context->output.position;
+            max = context->output.length - context->output.position;
+        }
+
+        if (max > context->block_produce_remaining) {
+            max = context->block_produce_remaining;
+        }
+
+        len = context->block_producer(context, buffer, max);
+        if (len == 0) {
+            /* no data available now */
+            return;
+        }
+        if (len > max) {
+            len = max;
+        }
+        if (context->output.length == 0) {
+            writeInterface(context, chunk, len);
+        } else {
+            context->output.position += len;
+        }
+        context->block_produce_remaining -= len;
+
+        if (context->block_produce_remaining == 0) {
+            context->block_producer = NULL;
+        }
+    }
 }
+#endif
 
 /**
  * Flush data to SCPI output
@@ -67,6 +350,14 @@ static size_t writeData(scpi_t * context, const char * data, size_t len) {
  * @return
  */
 static int flushData(scpi_t * context) {
+    if (context && context->interface) {
+        writeOutputBuffer(context);
+        if (context->output.position > 0) {
+            /* flush when the queued output is written by SCPI_OutputReady */
+            context->output_pending = TRUE;
+            return SCPI_RES_OK;
+        }
+    }
     if (context && context->interface && context->interface->flush) {
         return context->interface->flush(context);
     } else {
@@ -93,6 +384,14 @@ static size_t writeDelimiter(scpi_t * context) {
  * @return number of characters written
  */
 static size_t writeNewLine(scpi_t * context) {
+#if USE_BLOCK_STREAMING
+    if (context->block_producer != NULL) {
+        /* line ending is written after the block by SCPI_OutputReady */
+        context->output_pending = TRUE;
+        SCPI_OutputReady(context);
+        return 0;
+    }
+#endif
     if (!context->first_output) {
         size_t len;
 #ifndef SCPI_LINE_ENDING
@@ -102,6 +401,10 @@ static size_t writeNewLine(scpi_t * context) {
         flushData(context);
         return len;
     } else {
+        if (context->output.position > 0) {
+            /* output of failed query is not terminated, but not held back */
+            flushData(context);
+        }
         return 0;
     }
 }
@@ -129,6 +432,14 @@ static scpi_bool_t processCommand(scpi_t * context) {
     scpi_bool_t result = TRUE;
     scpi_bool_t is_query = context->param_list.cmd_raw.data[context->param_list.cmd_raw.length - 1] == '?';
 
+#if USE_BLOCK_STREAMING
+    if (is_query && (context->block_producer != NULL)) {
+        /* produced block must be the last result of the message */
+        SCPI_ErrorPush(context, SCPI_ERROR_QUERY_UNTERM_INDEF_RESP);
+        return FALSE;
+    }
+#endif
+
     /* conditionally write ; */
     if(!context->first_output && is_query) {
         writeData(context, ";", 1);
@@ -166,24 +477,388 @@ static scpi_bool_t processCommand(scpi_t * context) {
     return result;
 }
 
+/**
+ * State of command tree compilation
+ */
+struct _command_tree_builder_t {
+    scpi_command_node_t * nodes;
+    size_t count;
+    size_t size;
+};
+typedef struct _command_tree_builder_t command_tree_builder_t;
+
+/**
+ * Find child node with the same mnemonic or create new one
+ * @param builder
+ * @param node parent node
+ * @param mnemonic pattern of mnemonic, e.g. "MEASure" or "CHANnel#"
+ * @param len length of mnemonic
+ * @return child node or NULL if there is no space for new node
+ */
+static scpi_command_node_t * commandNodeChild(command_tree_builder_t * builder, scpi_command_node_t * node, const char * mnemonic, size_t len) {
+    scpi_command_node_t * child;
+    scpi_command_node_t * last = NULL;
+
+    for (child = (scpi_command_node_t *) node->child; child != NULL; child = (scpi_command_node_t *) child->sibling) {
+        if ((child->len == len) && (memcmp(child->mnemonic, mnemonic, len) == 0)) {
+            return child;
+        }
+        last = child;
+    }
+
+    if (builder->count >= builder->size) {
+        return NULL;
+    }
+
+    child = &builder->nodes[builder->count++];
+    memset(child, 0, sizeof (*child));
+    child->mnemonic = mnemonic;
+    child->len = len;
+
+    /* keep children in order of the command list */
+    if (last == NULL) {
+        node->child = child;
+    } else {
+        last->sibling = child;
+    }
+
+    return child;
+}
+
+/**
+ * Insert all variants of command pattern to the tree. Every optional
+ * mnemonic (inside [...]) creates two branches, with and without it.
+ * @param builder
+ * @param node current node
+ * @param pattern rest of the pattern without trailing '?'
+ * @param len length of the pattern
+ * @param brackets depth of optional part at the beginning of pattern
+ * @param cmd command definition
+ * @param query TRUE if the pattern is query
+ * @return FALSE if there are not enough nodes
+ */
+static scpi_bool_t commandNodeInsert(command_tree_builder_t * builder, scpi_command_node_t * node, const char * pattern, size_t len, int brackets, const scpi_command_t * cmd, scpi_bool_t query) {
+    size_t i;
+    const char * separator;
+
+    while (len > 0) {
+        switch (pattern[0]) {
+            case ':':
+                break;
+            case '[':
+                brackets++;
+                break;
+            case ']':
+                brackets--;
+                break;
+            default:
+                separator = strnpbrk(pattern, len, ":[]");
+                i = separator ? (size_t) (separator - pattern) : len;
+
+                /* branch without optional mnemonic */
+                if ((brackets > 0) && !commandNodeInsert(builder, node, pattern + i, len - i, brackets, cmd, query)) {
+                    return FALSE;
+                }
+
+                node = commandNodeChild(builder, node, pattern, i);
+                if (node == NULL) {
+                    return FALSE;
+                }
+                pattern += i;
+                len -= i;
+                continue;
+        }
+        pattern++;
+        len--;
+    }
+
+    if (query) {
+        if (node->query == NULL) {
+            node->query = cmd;
+        }
+    } else {
+        if (node->command == NULL) {
+            node->command = cmd;
+        }
+    }
+
+    return TRUE;
+}
+
+/**
+ * Compile command list to the tree of mnemonics, so the command lookup
+ * does not need to scan the whole command list.
+ *
+ * Tree is stored in user supplied array of nodes. It must be called after
+ * SCPI_DefinitionInit and the command list must not change after
+ * compilation. Every optional mnemonic doubles number of nodes needed by
+ * the pattern, so the array should be sized with some reserve.
+ *
+ * @param definition
+ * @param nodes storage for the tree
+ * @param nodes_len number of nodes in the storage
+ * @return number of used nodes or 0 if the storage was too small. In that
+ * case, the command list is searched linearly as before.
+ */
+size_t SCPI_DefinitionCompileCommands(scpi_definition_t * definition, scpi_command_node_t * nodes, size_t nodes_len) {
+    command_tree_builder_t builder;
+    const scpi_command_t * cmd;
+    size_t len;
+    scpi_bool_t query;
+
+    if (definition == NULL) {
+        return 0;
+    }
+
+    definition->cmdtree = NULL;
+
+    if ((nodes == NULL) || (nodes_len == 0) || (definition->cmdlist == NULL)) {
+        return 0;
+    }
+
+    builder.nodes = nodes;
+    builder.size = nodes_len;
+    builder.count = 1;
+    memset(&nodes[0], 0, sizeof (nodes[0]));
+
+    for (cmd = definition->cmdlist; cmd->pattern != NULL; cmd++) {
+        len = strlen(cmd->pattern);
+        query = (len > 0) && (cmd->pattern[len - 1] == '?');
+        if (query) {
+            len--;
+        }
+
+        if (!commandNodeInsert(&builder, &nodes[0], cmd->pattern, len, 0, cmd, query)) {
+            return 0;
+        }
+    }
+
+    definition->cmdtree = &nodes[0];
+    return builder.count;
+}
+
+#if USE_SESSION_DEFINITION
+/**
+ * Compile command list of the context set by SCPI_Init
+ * @param context
+ * @param nodes storage for the tree
+ * @param nodes_len number of nodes in the storage
+ * @return number of used nodes or 0. Shared definition of the session is
+ * not changed, SCPI_ERROR_SYSTEM_ERROR is pushed instead. It is compiled
+ * by SCPI_DefinitionCompileCommands.
+ */
+size_t SCPI_CompileCommands(scpi_t * context, scpi_command_node_t * nodes, size_t nodes_len) {
+    if (context == NULL) {
+        return 0;
+    }
+
+    if (context->definition != &context->local_definition) {
+        SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+        return 0;
+    }
+
+    return SCPI_DefinitionCompileCommands(&context->local_definition, nodes, nodes_len);
+}
+#endif
+
+/**
+ * Search the compiled tree for all commands matching the header.
+ *
+ * If more patterns match the header, the first one from the command list
+ * is returned, so the result is the same as of the linear search.
+ *
+ * @param node current node
+ * @param header rest of the header without trailing '?'
+ * @param len length of header
+ * @param query TRUE if the header is query
+ * @return command definition or NULL
+ */
+static const scpi_command_t * findCommandNodeRecursive(const scpi_command_node_t * node, const char * header, size_t len, scpi_bool_t query) {
+    const scpi_command_node_t * child;
+    const scpi_command_t * result = NULL;
+    const scpi_command_t * cmd;
+    const char * separator;
+    size_t sep;
+
+    if (len == 0) {
+        return query ? node->query : node->command;
+    }
+
+    separator = strnpbrk(header, len, ":");
+    sep = separator ? (size_t) (separator - header) : len;
+
+    for (child = node->child; child != NULL; child = child->sibling) {
+        if (matchPattern(child->mnemonic, child->len, header, sep, NULL)) {
+            if (sep < len) {
+                cmd = findCommandNodeRecursive(child, header + sep + 1, len - sep - 1, query);
+            } else {
+                cmd = findCommandNodeRecursive(child, header + sep, 0, query);
+            }
+            if ((cmd != NULL) && ((result == NULL) || (cmd < result))) {
+                result = cmd;
+            }
+        }
+    }
+
+    return result;
+}
+
+/**
+ * Find command for the header in the compiled tree
+ * @param tree root node of the tree
+ * @param header
+ * @param len
+ * @return command definition or NULL
+ */
+static const scpi_command_t * findCommandNode(const scpi_command_node_t * tree, const char * header, size_t len) {
+    scpi_bool_t query = FALSE;
+
+    if ((len > 0) && (header[len - 1] == '?')) {
+        query = TRUE;
+        len--;
+    }
+
+    if ((len >= 2) && (header[0] == ':')) {
+        /* handle errornouse ":*IDN?" */
+        if (header[1] == '*') {
+            return NULL;
+        }
+        header++;
+        len--;
+    }
+
+    return findCommandNodeRecursive(tree, header, len, query);
+}
+
+#if USE_PRECOMPILED_COMMANDS
+/**
+ * Find command in tables generated by tools/cmdhash.c
+ *
+ * Perfect hash of normalized header selects the only slot where the header
+ * can be. All commands of the slot are then verified in order of the
+ * command list, so unknown headers falling to some slot are rejected.
+ *
+ * @param table precompiled tables
+ * @param header
+ * @param len
+ * @return command definition or NULL
+ */
+static const scpi_command_t * findPrecompiledCommand(const scpi_precompiled_commands_t * table, const char * header, size_t len) {
+    uint32_t h1, h2;
+    uint16_t slot;
+    uint16_t i;
+    const scpi_command_t * cmd;
+
+    hashCommandHeader(header, len, &h1, &h2);
+    slot = hashCommandSlot(h2, table->displacements[h1 % table->buckets], table->size);
+
+    for (i = table->slots[slot]; i < table->slots[slot + 1]; i++) {
+        cmd = &table->cmdlist[table->commands[i]];
+        if (matchCommand(cmd->pattern, header, len, NULL, 0, 0)) {
+            return cmd;
+        }
+    }
+
+    return NULL;
+}
+#endif /* USE_PRECOMPILED_COMMANDS */
+
+/**
+ * Cycle all patterns and search matching pattern
+ * @param context
+ * @param header
+ * @param len
+ * @return matching command or NULL
+ */
+static const scpi_command_t * findCommand(scpi_t * context, const char * header, int len) {
+    const scpi_definition_t * definition = context->definition;
+    int32_t i;
+    const scpi_command_t * cmd;
+
+#if USE_PRECOMPILED_COMMANDS
+    if (definition->cmdlist == scpi_precompiled_commands.cmdlist) {
+        return findPrecompiledCommand(&scpi_precompiled_commands, header, len);
+    }
+#endif
+
+    if (definition->cmdtree != NULL) {
+        cmd = findCommandNode(definition->cmdtree, header, len);
+        if (cmd == NULL) {
+            return NULL;
+        }
+        /* the tree can produce false positives only for unusual patterns,
+         * those are resolved by the linear scan below */
+        if (matchCommand(cmd->pattern, header, len, NULL, 0, 0)) {
+            return cmd;
+        }
+    }
+
+    for (i = 0; definition->cmdlist[i].pattern != NULL; i++) {
+        cmd = &definition->cmdlist[i];
+        if (matchCommand(cmd->pattern, header, len, NULL, 0, 0)) {
+            return cmd;
+        }
+    }
+    return NULL;
+}
+
 /**
  * Cycle all patterns and search matching pattern. Execute command callback.
  * @param context
  * @result TRUE if context->paramlist is filled with correct values
  */
 static scpi_bool_t findCommandHeader(scpi_t * context, const char * header, int len) {
-    int32_t i;
-    const scpi_command_t * cmd;
+    const scpi_command_t * cmd = findCommand(context, header, len);
+
+    if (cmd == NULL) {
+        return FALSE;
+    }
+    context->param_list.cmd = cmd;
+    return TRUE;
+}
+
+#if USE_BLOCK_STREAMING
+/**
+ * Check if block of the current command was rejected by its block_sink
+ * @param context
+ * @param message - beginning of the program message
+ * @return TRUE if the command callback must not be called
+ */
+static scpi_bool_t inputStreamFailed(scpi_t * context, const char * message) {
+    const scpi_parser_state_t * state = &context->parser_state;
+    const char * data = state->programData.ptr;
+    const char * block = message + state->input_failed;
+
+    if ((state->input_failed == 0) || (context->param_list.cmd->block_sink == NULL) || (data == NULL)) {
+        return FALSE;
+    }
+
+    return (block >= data) && (block < data + state->programData.len);
+}
+#endif /* USE_BLOCK_STREAMING */
+
+#if USE_SESSION_DEFINITION
+/**
+ * Apply changes of deprecated cmdlist, units and idn fields of the context
+ * to the own definition. Compiled tree and index are dropped if the tables
+ * were replaced.
+ * @param context
+ */
+static void updateLocalDefinition(scpi_t * context) {
+    scpi_definition_t * definition = &context->local_definition;
 
-    for (i = 0; context->cmdlist[i].pattern != NULL; i++) {
-        cmd = &context->cmdlist[i];
-        if (matchCommand(cmd->pattern, header, len, NULL, 0, 0)) {
-            context->param_list.cmd = cmd;
-            return TRUE;
-        }
+    if (context->definition != definition) {
+        return;
+    }
+
+    if ((definition->cmdlist != context->cmdlist) || (definition->units != context->units)) {
+        SCPI_DefinitionInit(definition, context->cmdlist, context->units,
+                context->idn[0], context->idn[1], context->idn[2], context->idn[3]);
+    } else {
+        memcpy(definition->idn, context->idn, sizeof (definition->idn));
     }
-    return FALSE;
 }
+#endif
 
 /**
  * Parse one command line
@@ -196,18 +871,58 @@ scpi_bool_t SCPI_Parse(scpi_t * context, char * data, int len) {
     scpi_bool_t result = TRUE;
     scpi_parser_state_t * state;
     int r;
-    scpi_token_t cmd_prev = {SCPI_TOKEN_UNKNOWN, NULL, 0};
+    scpi_token_t cmd_prev;
+#if USE_BLOCK_STREAMING
+    const char * message = data;
+#endif
+#if SCPI_PARAMETER_TOKENS_MAX > 0
+    scpi_parameter_token_t parameters[SCPI_PARAMETER_TOKENS_MAX];
+#else
+    scpi_parameter_token_t * parameters = NULL;
+#endif
 
     if (context == NULL) {
         return FALSE;
     }
 
+#if USE_LOCKFREE_ERROR_QUEUE
+    SCPI_ErrorSync(context);
+#endif
+#if USE_ATOMIC_REGISTERS
+    SCPI_RegSync(context);
+#endif
+#if USE_SESSION_DEFINITION
+    updateLocalDefinition(context);
+#endif
+
+    /*
+     * Previous response is not read yet. If peer already got part of it,
+     * e.g. header of arbitrary block, it is completed, otherwise it is
+     * discarded, IEEE 488.2 6.3.2.3
+     */
+    if (context->output_pending && !SCPI_OutputReady(context) && !context->output_started) {
+        context->output.position = 0;
+        context->output_pending = FALSE;
+#if USE_BLOCK_STREAMING
+        context->block_producer = NULL;
+#endif
+        SCPI_ErrorPush(context, SCPI_ERROR_QUERY_INTERRUPTED);
+    }
+    if (!context->output_pending) {
+        context->output_started = FALSE;
+    }
+    context->output_deadlocked = FALSE;
+
+    cmd_prev.type = SCPI_TOKEN_UNKNOWN;
+    cmd_prev.ptr = NULL;
+    cmd_prev.len = 0;
+
     state = &context->parser_state;
     context->output_count = 0;
     context->first_output = TRUE;
 
     while (1) {
-        r = scpiParser_detectProgramMessageUnit(state, data, len);
+        r = scpiParser_detectProgramMessageUnit(state, data, len, parameters, SCPI_PARAMETER_TOKENS_MAX);
 
         if (state->programHeader.type == SCPI_TOKEN_INVALID) {
             SCPI_ErrorPush(context, SCPI_ERROR_INVALID_CHARACTER);
@@ -216,8 +931,20 @@ scpi_bool_t SCPI_Parse(scpi_t * context, char * data, int len) {
 
             composeCompoundCommand(&cmd_prev, &state->programHeader);
 
-            if (findCommandHeader(context, state->programHeader.ptr, state->programHeader.len)) {
-
+            if (!findCommandHeader(context, state->programHeader.ptr, state->programHeader.len)) {
+                /* place undefined header with error */
+                /* calculate length of errorenous header and trim \r\n */
+                size_t r2 = r;
+                while (r2 > 0 && (data[r2 - 1] == '\r' || data[r2 - 1] == '\n')) r2--;
+                SCPI_ErrorPushEx(context, SCPI_ERROR_UNDEFINED_HEADER, data, r2);
+                result = FALSE;
+#if USE_BLOCK_STREAMING
+            } else if (inputStreamFailed(context, message)) {
+                /* error was reported when block_sink rejected the block */
+                result = FALSE;
+                cmd_prev = state->programHeader;
+#endif
+            } else {
                 context->param_list.lex_state.buffer = state->programData.ptr;
                 context->param_list.lex_state.pos = context->param_list.lex_state.buffer;
                 context->param_list.lex_state.len = state->programData.len;
@@ -225,15 +952,14 @@ scpi_bool_t SCPI_Parse(scpi_t * context, char * data, int len) {
                 context->param_list.cmd_raw.position = 0;
                 context->param_list.cmd_raw.length = state->programHeader.len;
 
+#if SCPI_PARAMETER_TOKENS_MAX > 0
+                state->parameters = parameters;
+#endif
                 result &= processCommand(context);
+#if SCPI_PARAMETER_TOKENS_MAX > 0
+                state->parameters = NULL;
+#endif
                 cmd_prev = state->programHeader;
-            } else {
-                /* place undefined header with error */
-                /* calculate length of errorenous header and trim \r\n */
-                size_t r2 = r;
-                while (r2 > 0 && (data[r2 - 1] == '\r' || data[r2 - 1] == '\n')) r2--;
-                SCPI_ErrorPushEx(context, SCPI_ERROR_UNDEFINED_HEADER, data, r2);
-                result = FALSE;
             }
         }
 
@@ -246,12 +972,73 @@ scpi_bool_t SCPI_Parse(scpi_t * context, char * data, int len) {
 
     }
 
+#if USE_BLOCK_STREAMING
+    state->input_failed = 0;
+#endif
+
     /* conditionally write new line */
     writeNewLine(context);
 
     return result;
 }
 
+/**
+ * Initialize instrument definition. It is read-only after initialization
+ * and compilation, so it can be shared by any number of sessions.
+ * @param definition
+ * @param commands
+ * @param units
+ * @param idn1
+ * @param idn2
+ * @param idn3
+ * @param idn4
+ */
+void SCPI_DefinitionInit(scpi_definition_t * definition,
+        const scpi_command_t * commands,
+        const scpi_unit_def_t * units,
+        const char * idn1, const char * idn2, const char * idn3, const char * idn4) {
+    memset(definition, 0, sizeof (*definition));
+    definition->cmdlist = commands;
+    definition->units = units;
+    definition->idn[0] = idn1;
+    definition->idn[1] = idn2;
+    definition->idn[2] = idn3;
+    definition->idn[3] = idn4;
+#if USE_BLOCK_STREAMING
+    for (; commands->pattern != NULL; commands++) {
+        if (commands->block_sink != NULL) {
+            definition->block_streaming = TRUE;
+        }
+    }
+#endif
+}
+
+/**
+ * Initialize SCPI session using shared instrument definition. Only the
+ * session state is stored in the context.
+ * @param context
+ * @param definition
+ * @param interface
+ * @param input_buffer
+ * @param input_buffer_length
+ * @param error_queue_data
+ * @param error_queue_size
+ */
+void SCPI_InitSession(scpi_t * context,
+        const scpi_definition_t * definition,
+        scpi_interface_t * interface,
+        char * input_buffer, size_t input_buffer_length,
+        scpi_error_t * error_queue_data, int16_t error_queue_size) {
+    memset(context, 0, sizeof (*context));
+    context->definition = definition;
+    context->interface = interface;
+    context->buffer.data = input_buffer;
+    context->buffer.length = input_buffer_length;
+    context->buffer.position = 0;
+    SCPI_ErrorInit(context, error_queue_data, error_queue_size);
+}
+
+#if USE_SESSION_DEFINITION
 /**
  * Initialize SCPI context structure
  * @param context
@@ -274,18 +1061,88 @@ void SCPI_Init(scpi_t * context,
         const char * idn1, const char * idn2, const char * idn3, const char * idn4,
         char * input_buffer, size_t input_buffer_length,
         scpi_error_t * error_queue_data, int16_t error_queue_size) {
-    memset(context, 0, sizeof (*context));
+    /* session is cleared first, the own definition is part of it */
+    SCPI_InitSession(context, &context->local_definition, interface,
+            input_buffer, input_buffer_length, error_queue_data, error_queue_size);
     context->cmdlist = commands;
-    context->interface = interface;
     context->units = units;
     context->idn[0] = idn1;
     context->idn[1] = idn2;
     context->idn[2] = idn3;
     context->idn[3] = idn4;
-    context->buffer.data = input_buffer;
-    context->buffer.length = input_buffer_length;
-    context->buffer.position = 0;
-    SCPI_ErrorInit(context, error_queue_data, error_queue_size);
+    SCPI_DefinitionInit(&context->local_definition, commands, units, idn1, idn2, idn3, idn4);
+}
+#endif
+
+/**
+ * Set buffer which collects output of the whole response message, so it is
+ * written by one interface write call. Data longer than the buffer are
+ * written directly.
+ *
+ * With the buffer, interface write may accept less data than offered. The
+ * rest is queued in the buffer and written by SCPI_OutputReady. If the buffer
+ * gets full during a command, write is tried SCPI_OUTPUT_WRITE_RETRIES more
+ * times. When it still accepts nothing, rest of the response message is
+ * discarded and -430 "Query DEADLOCKED" reported, so responses bigger than
+ * the buffer should be produced by SCPI_ResultArbitraryBlockProducer.
+ * @param context
+ * @param output_buffer - storage for the output or NULL to disable buffering
+ * @param output_buffer_length
+ */
+void SCPI_InitOutputBuffer(scpi_t * context, char * output_buffer, size_t output_buffer_length) {
+    writeOutputBuffer(context);
+    context->output.data = output_buffer;
+    context->output.length = output_buffer ? output_buffer_length : 0;
+    context->output.position = 0;
+    context->output_pending = FALSE;
+    context->output_deadlocked = FALSE;
+#if USE_BLOCK_STREAMING
+    context->block_producer = NULL;
+#endif
+}
+
+/**
+ * Continue writing of queued output, call it when the interface is able to
+ * accept more data
+ * @param context
+ * @return TRUE if all output is written
+ */
+scpi_bool_t SCPI_OutputReady(scpi_t * context) {
+#if USE_BLOCK_STREAMING
+    if (context->block_producer != NULL) {
+        produceOutput(context);
+        if (context->block_producer != NULL) {
+            writeOutputBuffer(context);
+            return FALSE;
+        }
+        /* line ending follows the produced block */
+        writeData(context, SCPI_LINE_ENDING, strlen(SCPI_LINE_ENDING));
+    }
+#endif
+    writeOutputBuffer(context);
+    if (context->output.position > 0) {
+        return FALSE;
+    }
+
+    if (context->output_pending) {
+        context->output_pending = FALSE;
+        if (context->interface->flush) {
+            context->interface->flush(context);
+        }
+    }
+    return TRUE;
+}
+
+/**
+ * Check whether some response is waiting for SCPI_OutputReady. Input should
+ * not be passed to the parser while output is pending. If no part of the
+ * pending response was written yet, it is discarded and -410 "Query
+ * INTERRUPTED" reported otherwise.
+ * @param context
+ * @return TRUE if output is pending
+ */
+scpi_bool_t SCPI_OutputPending(scpi_t * context) {
+    return context->output_pending;
 }
 
 #if USE_DEVICE_DEPENDENT_ERROR_INFORMATION && !USE_MEMORY_ALLOCATION_FREE
@@ -303,6 +1160,326 @@ void SCPI_InitHeap(scpi_t * context,
 }
 #endif
 
+/**
+ * Reset input scanner to the beginning of program message
+ * @param state
+ */
+static void inputScannerReset(scpi_parser_state_t * state) {
+    state->input_state = SCPI_INPUT_STATE_UNIT;
+    state->input_pos = 0;
+    state->input_remaining = 0;
+    state->input_digits = 0;
+    state->input_quote = 0;
+#if USE_BLOCK_STREAMING
+    state->input_cmd = NULL;
+    state->input_units = 0;
+#endif
+}
+
+/**
+ * Can character start program header
+ * @param c
+ * @return
+ */
+static scpi_bool_t isHeaderStart(int c) {
+    return scpiLex_IsCharClass(c, SCPI_CHAR_HEADER_START);
+}
+
+/**
+ * Is character allowed in program header
+ * @param c
+ * @return
+ */
+static scpi_bool_t isHeaderCharacter(int c) {
+    return scpiLex_IsCharClass(c, SCPI_CHAR_HEADER);
+}
+
+#if USE_BLOCK_STREAMING
+
+/**
+ * Find command of the first program message unit the same way as SCPI_Parse
+ * does, but without modification of the input buffer. Later units are not
+ * considered, their blocks would be streamed before commands of earlier
+ * units are executed.
+ * @param context
+ * @param header - program header of the unit
+ * @param len - length of the header
+ */
+static void inputScannerHeader(scpi_t * context, char * header, size_t len) {
+    scpi_parser_state_t * state = &context->parser_state;
+    lex_state_t lex_state;
+    scpi_token_t token;
+
+    state->input_cmd = NULL;
+
+    lex_state.buffer = lex_state.pos = header;
+    lex_state.len = len;
+    if ((size_t) scpiLex_ProgramHeader(&lex_state, &token) != len) {
+        return;
+    }
+
+    state->input_cmd = findCommand(context, header, len);
+}
+
+/**
+ * Pass part of streamed block to the command
+ * @param context
+ * @param data
+ * @param len - available data
+ * @return number of bytes consumed from the data
+ */
+static size_t inputStreamData(scpi_t * context, const char * data, size_t len) {
+    scpi_parser_state_t * state = &context->parser_state;
+    const scpi_command_t * cmd = state->input_cmd;
+
+    if (len > state->input_remaining) {
+        len = state->input_remaining;
+    }
+
+    if ((cmd != NULL) && (len > 0)) {
+        context->param_list.cmd = cmd;
+        if (cmd->block_sink(context, state->input_total, state->input_total - state->input_remaining, data, len) != SCPI_RES_OK) {
+            SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+            /* ignore rest of the block and callback of the command */
+            state->input_cmd = NULL;
+            state->input_failed = state->input_block;
+        }
+    }
+
+    state->input_remaining -= len;
+    if (state->input_remaining == 0) {
+        state->input_state = SCPI_INPUT_STATE_DATA;
+    }
+
+    return len;
+}
+
+/**
+ * Pass block data from the input buffer to the command and remove them
+ * from the buffer
+ * @param context
+ * @param buffer - input buffer
+ * @param pos - position of the data in the buffer
+ */
+static void inputStreamBuffer(scpi_t * context, scpi_buffer_t * buffer, size_t pos) {
+    size_t end = pos + inputStreamData(context, buffer->data + pos, buffer->position - pos);
+    size_t keep = context->parser_state.input_block + 3;
+
+    memmove(buffer->data + keep, buffer->data + end, buffer->position - end);
+    buffer->position -= end - keep;
+    if (buffer->position < buffer->length) {
+        buffer->data[buffer->position] = 0;
+    }
+}
+#endif /* USE_BLOCK_STREAMING */
+
+/**
+ * Search for the end of program message in the input buffer. Scanning
+ * continues where the previous call stopped, so each byte is examined only
+ * once and content of arbitrary block is skipped at once.
+ *
+ * Strings and blocks are recognized on the same places as by the lexer.
+ * New line inside of block does not terminate the message. New line inside
+ * of string is part of it only if the closing quote is already received,
+ * otherwise it terminates the message and the lexer rejects the string, so
+ * the following messages are not held back by a missing quote.
+ *
+ * Block of command with block_sink in the first program message unit is
+ * passed to the command and replaced by empty block #10 in the buffer.
+ *
+ * @param context
+ * @param buffer - input buffer, position is the length of data
+ * @return length of program message including terminator or 0 if the
+ * message is incomplete
+ */
+static size_t inputScannerFindEnd(scpi_t * context, scpi_buffer_t * buffer) {
+    scpi_parser_state_t * state = &context->parser_state;
+    char * data = buffer->data;
+    size_t len = buffer->position;
+    size_t pos = state->input_pos;
+    size_t skip;
+    int c;
+
+    while (pos < len) {
+        c = (unsigned char) data[pos];
+
+        switch (state->input_state) {
+            case SCPI_INPUT_STATE_BLOCK_DATA:
+                skip = len - pos;
+                if (skip > state->input_remaining) {
+                    skip = state->input_remaining;
+                }
+                pos += skip;
+                state->input_remaining -= skip;
+                if (state->input_remaining == 0) {
+                    state->input_state = SCPI_INPUT_STATE_DATA;
+                }
+                continue;
+#if USE_BLOCK_STREAMING
+            case SCPI_INPUT_STATE_BLOCK_STREAM:
+                inputStreamBuffer(context, buffer, pos);
+                pos = state->input_block + 3;
+                len = buffer->position;
+                continue;
+#endif
+            case SCPI_INPUT_STATE_STRING:
+                skip = scpiLex_SpanStringLine(data + pos, len - pos, state->input_quote);
+                if (skip > 0) {
+                    pos += skip;
+                    continue;
+                }
+                if (scpiLex_IsCharClass(c, SCPI_CHAR_TERMINATOR)) {
+                    /* new line is part of the string only if its quote is already received */
+                    skip = scpiLex_SpanString(data + pos, len - pos, state->input_quote);
+                    if ((pos + skip < len) && (data[pos + skip] == state->input_quote)) {
+                        pos += skip;
+                        continue;
+                    }
+                    /* lexer does not accept the string, new line terminates the message */
+                    state->input_state = SCPI_INPUT_STATE_DATA;
+                    break;
+                }
+                if (c == state->input_quote) {
+                    state->input_state = SCPI_INPUT_STATE_STRING_QUOTE;
+                } else if (c > 0x7f) {
+                    /* lexer does not accept the string, so new line terminates the message */
+                    state->input_state = SCPI_INPUT_STATE_DATA;
+                }
+                pos++;
+                continue;
+            case SCPI_INPUT_STATE_STRING_QUOTE:
+                if (c == state->input_quote) {
+                    /* doubled quote is part of the string */
+                    state->input_state = SCPI_INPUT_STATE_STRING;
+                    pos++;
+                    continue;
+                }
+                state->input_state = SCPI_INPUT_STATE_DATA;
+                break;
+            case SCPI_INPUT_STATE_BLOCK:
+                if ((c >= '1') && (c <= '9')) {
+                    state->input_state = SCPI_INPUT_STATE_BLOCK_LENGTH;
+                    state->input_digits = c - '0';
+                    state->input_remaining = 0;
+                    pos++;
+                    continue;
+                }
+                state->input_state = SCPI_INPUT_STATE_DATA;
+                break;
+            case SCPI_INPUT_STATE_BLOCK_LENGTH:
+                if (scpiLex_IsCharClass(c, SCPI_CHAR_DIGIT)) {
+                    state->input_remaining = state->input_remaining * 10 + (c - '0');
+                    state->input_digits--;
+                    pos++;
+                    if (state->input_digits == 0) {
+                        if (state->input_remaining == 0) {
+                            state->input_state = SCPI_INPUT_STATE_DATA;
+#if USE_BLOCK_STREAMING
+                        } else if ((state->input_cmd != NULL) && (state->input_cmd->block_sink != NULL)) {
+                            state->input_state = SCPI_INPUT_STATE_BLOCK_STREAM;
+                            state->input_total = state->input_remaining;
+                            memcpy(data + state->input_block, "#10", 3);
+                            inputStreamBuffer(context, buffer, pos);
+                            pos = state->input_block + 3;
+                            len = buffer->position;
+#endif
+                        } else {
+                            state->input_state = SCPI_INPUT_STATE_BLOCK_DATA;
+                        }
+                    }
+                    continue;
+                }
+                state->input_state = SCPI_INPUT_STATE_DATA;
+                break;
+            case SCPI_INPUT_STATE_DATA:
+                /* skip characters which can not change the state */
+                skip = scpiLex_SpanData(data + pos, len - pos);
+                if (skip > 0) {
+                    pos += skip;
+                    continue;
+                }
+                break;
+            default:
+                break;
+        }
+
+        /* character outside of string and block */
+        pos++;
+
+        if (scpiLex_IsCharClass(c, SCPI_CHAR_TERMINATOR)) {
+            if ((c == '\r') && (pos < len) && (data[pos] == '\n')) {
+                pos++;
+            }
+            inputScannerReset(state);
+            return pos;
+        }
+
+        switch (state->input_state) {
+            case SCPI_INPUT_STATE_UNIT:
+                if ((c != ' ') && (c != '\t') && (c != ';')) {
+#if USE_BLOCK_STREAMING
+                    state->input_cmd = NULL;
+                    state->input_units++;
+#endif
+                    if (isHeaderStart(c)) {
+                        state->input_state = SCPI_INPUT_STATE_HEADER;
+#if USE_BLOCK_STREAMING
+                        state->input_header = pos - 1;
+#endif
+                    } else {
+                        state->input_state = SCPI_INPUT_STATE_DATA;
+                    }
+                }
+                break;
+            case SCPI_INPUT_STATE_HEADER:
+#if USE_BLOCK_STREAMING
+                if (!isHeaderCharacter(c) && context->definition->block_streaming
+                        && (state->input_units == 1)) {
+                    inputScannerHeader(context, data + state->input_header, pos - 1 - state->input_header);
+                }
+#endif
+                /* fall through */
+            case SCPI_INPUT_STATE_DATA_HEADER:
+                if ((c == ' ') || (c == '\t') || (c == ',')) {
+                    state->input_state = SCPI_INPUT_STATE_PARAMETER;
+                } else if (c == ';') {
+                    state->input_state = SCPI_INPUT_STATE_UNIT;
+                } else if (!isHeaderCharacter(c)) {
+                    state->input_state = SCPI_INPUT_STATE_DATA;
+                }
+                break;
+            case SCPI_INPUT_STATE_PARAMETER:
+                if (scpiLex_IsCharClass(c, SCPI_CHAR_QUOTE)) {
+                    state->input_state = SCPI_INPUT_STATE_STRING;
+                    state->input_quote = (char) c;
+                } else if (c == '#') {
+                    state->input_state = SCPI_INPUT_STATE_BLOCK;
+#if USE_BLOCK_STREAMING
+                    state->input_block = pos - 1;
+#endif
+                } else if (c == ';') {
+                    state->input_state = SCPI_INPUT_STATE_UNIT;
+                } else if ((c != ' ') && (c != '\t') && (c != ',')) {
+                    state->input_state = SCPI_INPUT_STATE_DATA;
+                }
+                break;
+            default:
+                if (c == ',') {
+                    state->input_state = SCPI_INPUT_STATE_PARAMETER;
+                } else if (c == ';') {
+                    state->input_state = SCPI_INPUT_STATE_UNIT;
+                } else if (isHeaderStart(c)) {
+                    /* parser resynchronizes on anything what looks like a header */
+                    state->input_state = SCPI_INPUT_STATE_DATA_HEADER;
+                }
+                break;
+        }
+    }
+
+    state->input_pos = pos;
+    return 0;
+}
+
 /**
  * Interface to the application. Adds data to system buffer and try to search
  * command line termination. If the termination is found or if len=0, command
@@ -315,44 +1492,164 @@ void SCPI_InitHeap(scpi_t * context,
  */
 scpi_bool_t SCPI_Input(scpi_t * context, const char * data, int len) {
     scpi_bool_t result = TRUE;
-    size_t totcmdlen = 0;
-    int cmdlen = 0;
+    scpi_buffer_t * buffer = &context->buffer;
+    scpi_buffer_t pending;
+    size_t start = context->parser_state.input_start;
+    size_t cmdlen;
 
     if (len == 0) {
-        context->buffer.data[context->buffer.position] = 0;
-        result = SCPI_Parse(context, context->buffer.data, context->buffer.position);
-        context->buffer.position = 0;
+        buffer->data[buffer->position] = 0;
+        result = SCPI_Parse(context, buffer->data + start, buffer->position - start);
+        buffer->position = 0;
+        context->parser_state.input_start = 0;
+        inputScannerReset(&context->parser_state);
     } else {
         int buffer_free;
 
-        buffer_free = context->buffer.length - context->buffer.position;
+#if USE_BLOCK_STREAMING
+        if (context->parser_state.input_state == SCPI_INPUT_STATE_BLOCK_STREAM) {
+            /* block data goes directly to the command */
+            cmdlen = inputStreamData(context, data, len);
+            data += cmdlen;
+            len -= cmdlen;
+            if (len == 0) {
+                return result;
+            }
+        }
+#endif
+
+        buffer_free = buffer->length - buffer->position;
+        if ((len > (buffer_free - 1)) && (start > 0)) {
+            /* make space by moving pending message to the beginning */
+            memmove(buffer->data, buffer->data + start, buffer->position - start);
+            buffer->position -= start;
+            buffer_free += start;
+            start = 0;
+        }
         if (len > (buffer_free - 1)) {
             /* Input buffer overrun - invalidate buffer */
-            context->buffer.position = 0;
-            context->buffer.data[context->buffer.position] = 0;
+            buffer->position = 0;
+            buffer->data[buffer->position] = 0;
+            context->parser_state.input_start = 0;
+            inputScannerReset(&context->parser_state);
+#if USE_BLOCK_STREAMING
+            context->parser_state.input_failed = 0;
+#endif
             SCPI_ErrorPush(context, SCPI_ERROR_INPUT_BUFFER_OVERRUN);
             return FALSE;
         }
-        memcpy(&context->buffer.data[context->buffer.position], data, len);
-        context->buffer.position += len;
-        context->buffer.data[context->buffer.position] = 0;
-
+        memcpy(&buffer->data[buffer->position], data, len);
+        buffer->position += len;
+        buffer->data[buffer->position] = 0;
 
+        /* consumed messages only advance start of the pending data */
         while (1) {
-            cmdlen = scpiParser_detectProgramMessageUnit(&context->parser_state, context->buffer.data + totcmdlen, context->buffer.position - totcmdlen);
-            totcmdlen += cmdlen;
-
-            if (context->parser_state.termination == SCPI_MESSAGE_TERMINATION_NL) {
-                result = SCPI_Parse(context, context->buffer.data, totcmdlen);
-                memmove(context->buffer.data, context->buffer.data + totcmdlen, context->buffer.position - totcmdlen);
-                context->buffer.position -= totcmdlen;
-                totcmdlen = 0;
-            } else {
-                if (context->parser_state.programHeader.type == SCPI_TOKEN_UNKNOWN
-                        && context->parser_state.termination == SCPI_MESSAGE_TERMINATION_NONE) break;
-                if (totcmdlen >= context->buffer.position) break;
+            pending.data = buffer->data + start;
+            pending.length = buffer->length - start;
+            pending.position = buffer->position - start;
+            cmdlen = inputScannerFindEnd(context, &pending);
+            buffer->position = start + pending.position;
+            if (cmdlen == 0) {
+                break;
             }
+            result = SCPI_Parse(context, pending.data, cmdlen);
+            start += cmdlen;
+        }
+
+        if (start == buffer->position) {
+            buffer->position = 0;
+            buffer->data[buffer->position] = 0;
+            start = 0;
+        }
+        context->parser_state.input_start = start;
+    }
+
+    return result;
+}
+
+/**
+ * Interface to the application. Parses complete program messages directly
+ * from the receive buffer of the application without copying them to the
+ * input buffer. Only the trailing incomplete message is copied to the input
+ * buffer. If there is already incomplete message in the input buffer, data
+ * are passed to it by SCPI_Input until the message is complete.
+ *
+ * If the trailing incomplete message does not fit to the input buffer, it
+ * is left in the application buffer and it is not counted as consumed.
+ * Application must pass it again together with following data. If it is
+ * all data passed, no progress is possible, so it is dropped and input
+ * buffer overrun is reported like by SCPI_Input.
+ *
+ * @param context
+ * @param data - data to process, content is modified by the parser
+ * @param len - length of data
+ * @param consumed - number of processed bytes
+ * @return
+ */
+scpi_bool_t SCPI_InputInPlace(scpi_t * context, char * data, size_t len, size_t * consumed) {
+    scpi_bool_t result = TRUE;
+    scpi_buffer_t input;
+    const char * nl;
+    size_t part;
+    size_t space;
+    size_t cmdlen;
+
+    *consumed = len;
+
+    /* finish pending message, copy data only up to the next new line */
+    while ((context->buffer.position > 0) && (len > 0)) {
+        nl = (const char *) memchr(data, '\n', len);
+        part = nl ? (size_t) (nl - data) + 1 : len;
+        space = context->buffer.length - 1 - (context->buffer.position - context->parser_state.input_start);
+#if USE_BLOCK_STREAMING
+        if (context->parser_state.input_state == SCPI_INPUT_STATE_BLOCK_STREAM) {
+            /* block data do not need the input buffer */
+            space = part;
+        }
+#endif
+        if ((part > space) && (space > 0)) {
+            /* copy only what fits, the rest is left to the application */
+            result &= SCPI_Input(context, data, space);
+            *consumed -= len - space;
+            return result;
         }
+        /* message can not fit at all, SCPI_Input reports the overrun */
+        result &= SCPI_Input(context, data, part);
+        data += part;
+        len -= part;
+    }
+
+    input.data = data;
+    input.length = len;
+    input.position = len;
+
+    while ((cmdlen = inputScannerFindEnd(context, &input)) > 0) {
+        result &= SCPI_Parse(context, input.data, cmdlen);
+        input.data += cmdlen;
+        input.length -= cmdlen;
+        input.position -= cmdlen;
+    }
+
+    if (input.position == 0) {
+        return result;
+    }
+
+    if (input.position < context->buffer.length) {
+        memcpy(context->buffer.data, input.data, input.position);
+        context->buffer.position = input.position;
+        context->buffer.data[context->buffer.position] = 0;
+    } else if ((input.position == input.length) && (input.position < *consumed)
+#if USE_BLOCK_STREAMING
+            && (context->parser_state.input_state != SCPI_INPUT_STATE_BLOCK_STREAM)
+#endif
+            ) {
+        /* unchanged by the scanner, leave it to the application */
+        inputScannerReset(&context->parser_state);
+        *consumed -= input.position;
+    } else {
+        inputScannerReset(&context->parser_state);
+        SCPI_ErrorPush(context, SCPI_ERROR_INPUT_BUFFER_OVERRUN);
+        result = FALSE;
     }
 
     return result;
@@ -490,7 +1787,13 @@ size_t SCPI_ResultUInt64Base(scpi_t * context, uint64_t val, int8_t base) {
 size_t SCPI_ResultFloat(scpi_t * context, float val) {
     char buffer[32];
     size_t result = 0;
-    size_t len = SCPI_FloatToStr(val, buffer, sizeof (buffer));
+    size_t len;
+
+    if (context->result_precision > 0) {
+        len = dtoaFloat(val, buffer, sizeof (buffer), context->result_precision);
+    } else {
+        len = SCPI_FloatToStr(val, buffer, sizeof (buffer));
+    }
     result += writeDelimiter(context);
     result += writeData(context, buffer, len);
     context->output_count++;
@@ -506,13 +1809,29 @@ size_t SCPI_ResultFloat(scpi_t * context, float val) {
 size_t SCPI_ResultDouble(scpi_t * context, double val) {
     char buffer[32];
     size_t result = 0;
-    size_t len = SCPI_DoubleToStr(val, buffer, sizeof (buffer));
+    size_t len;
+
+    if (context->result_precision > 0) {
+        len = dtoaDouble(val, buffer, sizeof (buffer), context->result_precision);
+    } else {
+        len = SCPI_DoubleToStr(val, buffer, sizeof (buffer));
+    }
     result += writeDelimiter(context);
     result += writeData(context, buffer, len);
     context->output_count++;
     return result;
 }
 
+/**
+ * Set number of significant digits of float and double results, e.g. by
+ * FORMat:ASCii command. Value is correctly rounded like by %.*g.
+ * @param context
+ * @param precision - number of significant digits, 0 = default formatting
+ */
+void SCPI_SetResultPrecision(scpi_t * context, int precision) {
+    context->result_precision = precision > 0 ? precision : 0;
+}
+
 /**
  * Write string within "" to the result
  * @param context
@@ -607,6 +1926,22 @@ size_t SCPI_ResultError(scpi_t * context, scpi_error_t * error) {
     return result;
 }
 
+/**
+ * Format arbitrary block header
+ * @param block_header - buffer for at least 12 characters
+ * @param len - length of block data
+ * @return length of header
+ */
+static size_t arbitraryBlockHeader(char * block_header, size_t len) {
+    size_t header_len;
+    block_header[0] = '#';
+    SCPI_UInt32ToStrBase((uint32_t) len, block_header + 2, 10, 10);
+
+    header_len = strlen(block_header + 2);
+    block_header[1] = (char) (header_len + '0');
+    return header_len + 2;
+}
+
 /**
  * Write arbitrary block header with length
  * @param context
@@ -617,15 +1952,12 @@ size_t SCPI_ResultArbitraryBlockHeader(scpi_t * context, size_t len) {
     size_t result = 0;
     char block_header[12];
     size_t header_len;
-    block_header[0] = '#';
-    SCPI_UInt32ToStrBase((uint32_t) len, block_header + 2, 10, 10);
 
-    header_len = strlen(block_header + 2);
-    block_header[1] = (char) (header_len + '0');
+    header_len = arbitraryBlockHeader(block_header, len);
 
     context->arbitrary_remaining = len;
     result  = writeDelimiter(context);
-    result += writeData(context, block_header, header_len + 2);
+    result += writeData(context, block_header, header_len);
     return result;
 }
 
@@ -661,11 +1993,54 @@ size_t SCPI_ResultArbitraryBlockData(scpi_t * context, const void * data, size_t
  */
 size_t SCPI_ResultArbitraryBlock(scpi_t * context, const void * data, size_t len) {
     size_t result = 0;
-    result += SCPI_ResultArbitraryBlockHeader(context, len);
-    result += SCPI_ResultArbitraryBlockData(context, data, len);
+    char block_header[12];
+    scpi_iovec_t iov[2];
+
+    iov[0].data = block_header;
+    iov[0].len = arbitraryBlockHeader(block_header, len);
+    iov[1].data = (const char *) data;
+    iov[1].len = (data != NULL) ? len : 0;
+
+    context->arbitrary_remaining = 0;
+    result += writeDelimiter(context);
+    /* header and data go out together, data are not copied */
+    result += writeVector(context, iov, 2);
+    context->output_count++;
     return result;
 }
 
+#if USE_BLOCK_STREAMING
+/**
+ * Write arbitrary block with data pulled from producer. With output buffer
+ * the data are produced after the response message is complete, as the
+ * interface accepts them in SCPI_OutputReady. Without output buffer the data
+ * are pulled immediately, until the producer has no data available, the
+ * rest is pulled by SCPI_OutputReady. If data remain, the block must be the
+ * last result of the message. Later queries of the message are rejected
+ * with -440 "Query UNTERMINATED after indefinite response".
+ * @param context
+ * @param len - length of block data
+ * @param producer - fills buffer with block data, see scpi_block_producer_t
+ * @return number of bytes of the block
+ */
+size_t SCPI_ResultArbitraryBlockProducer(scpi_t * context, size_t len, scpi_block_producer_t producer) {
+    size_t result;
+
+    result = SCPI_ResultArbitraryBlockHeader(context, len);
+    context->arbitrary_remaining = 0;
+    context->output_count++;
+
+    if (len > 0) {
+        context->block_producer = producer;
+        context->block_produce_remaining = len;
+        if (context->output.length == 0) {
+            produceOutput(context);
+        }
+    }
+    return result + len;
+}
+#endif
+
 /**
  * Write boolean value to the result
  * @param context
@@ -689,6 +2064,39 @@ static void invalidateToken(scpi_token_t * token, char * ptr) {
     token->type = SCPI_TOKEN_UNKNOWN;
 }
 
+#if SCPI_PARAMETER_TOKENS_MAX > 0
+/**
+ * Check if the parameter was already found by
+ * scpiParser_detectProgramMessageUnit of currently processed command and
+ * the lexer is just before it
+ * @param context
+ * @param index - index of the parameter
+ * @return
+ */
+static scpi_bool_t parameterTokenValid(scpi_t * context, int index) {
+    const scpi_parser_state_t * parser_state = &context->parser_state;
+    const lex_state_t * state = &context->param_list.lex_state;
+    const scpi_parameter_token_t * param;
+    const char * start;
+
+    if ((parser_state->parameters == NULL)
+            || (index >= SCPI_PARAMETER_TOKENS_MAX)
+            || (index >= parser_state->numberOfParameters)
+            || (state->buffer != parser_state->programData.ptr)
+            || (state->len != parser_state->programData.len)) {
+        return FALSE;
+    }
+
+    param = &parser_state->parameters[index];
+    start = (index == 0) ? state->buffer : parser_state->parameters[index - 1].end;
+
+    return (start == state->pos)
+            && (param->token.ptr >= start)
+            && (param->end >= param->token.ptr + param->token.len)
+            && (param->end <= state->buffer + state->len);
+}
+#endif
+
 /**
  * Get one parameter from command line
  * @param context
@@ -716,18 +2124,28 @@ scpi_bool_t SCPI_Parameter(scpi_t * context, scpi_parameter_t * parameter, scpi_
         }
         return FALSE;
     }
-    if (context->input_count != 0) {
-        scpiLex_Comma(state, parameter);
-        if (parameter->type != SCPI_TOKEN_COMMA) {
-            invalidateToken(parameter, NULL);
-            SCPI_ErrorPush(context, SCPI_ERROR_INVALID_SEPARATOR);
-            return FALSE;
+#if SCPI_PARAMETER_TOKENS_MAX > 0
+    if (parameterTokenValid(context, context->input_count)) {
+        /* token was already found by scpiParser_detectProgramMessageUnit */
+        *parameter = context->parser_state.parameters[context->input_count].token;
+        state->pos = context->parser_state.parameters[context->input_count].end;
+        context->input_count++;
+    } else
+#endif
+    {
+        if (context->input_count != 0) {
+            scpiLex_Comma(state, parameter);
+            if (parameter->type != SCPI_TOKEN_COMMA) {
+                invalidateToken(parameter, NULL);
+                SCPI_ErrorPush(context, SCPI_ERROR_INVALID_SEPARATOR);
+                return FALSE;
+            }
         }
-    }
 
-    context->input_count++;
+        context->input_count++;
 
-    scpiParser_parseProgramData(&context->param_list.lex_state, parameter);
+        scpiParser_parseProgramData(state, parameter);
+    }
 
     switch (parameter->type) {
         case SCPI_TOKEN_HEXNUM:
@@ -768,6 +2186,40 @@ scpi_bool_t SCPI_ParamIsNumber(scpi_parameter_t * parameter, scpi_bool_t suffixA
     }
 }
 
+#if USE_NUMERIC_TOKEN_VALUE
+/**
+ * Convert value of decimal integer found by lexer in the same way as
+ * strtol/strtoul/strtoll/strtoull with base 10 would convert its text
+ * @param parameter
+ * @param value result, negative numbers in two's complement
+ * @param sign
+ * @param max - biggest value returned by the strto* function
+ * @return FALSE if the value must be converted from text
+ */
+static scpi_bool_t decimalToInteger(const scpi_parameter_t * parameter, uint64_t * value, scpi_bool_t sign, uint64_t max) {
+    const scpi_decimal_t * decimal = &parameter->decimal;
+    uint64_t magnitude = decimal->mantissa;
+
+    /* fraction, exponent and 20th digit are handled by strto* */
+    if (!decimal->integer || (decimal->exponent != 0)) {
+        return FALSE;
+    }
+
+    if (sign) {
+        if (decimal->negative) {
+            *value = 0 - (magnitude > max ? max + 1 : magnitude);
+        } else {
+            *value = magnitude > max ? max : magnitude;
+        }
+    } else if (magnitude > max) {
+        *value = max;
+    } else {
+        *value = decimal->negative ? 0 - magnitude : magnitude;
+    }
+    return TRUE;
+}
+#endif
+
 /**
  * Convert parameter to signed/unsigned 32 bit integer
  * @param context
@@ -777,6 +2229,9 @@ scpi_bool_t SCPI_ParamIsNumber(scpi_parameter_t * parameter, scpi_bool_t suffixA
  * @return TRUE if succesful
  */
 static scpi_bool_t ParamSignToUInt32(scpi_t * context, scpi_parameter_t * parameter, uint32_t * value, scpi_bool_t sign) {
+#if USE_NUMERIC_TOKEN_VALUE
+    uint64_t value64;
+#endif
 
     if (!value) {
         SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
@@ -792,6 +2247,12 @@ static scpi_bool_t ParamSignToUInt32(scpi_t * context, scpi_parameter_t * parame
             return strBaseToUInt32(parameter->ptr, value, 2) > 0 ? TRUE : FALSE;
         case SCPI_TOKEN_DECIMAL_NUMERIC_PROGRAM_DATA:
         case SCPI_TOKEN_DECIMAL_NUMERIC_PROGRAM_DATA_WITH_SUFFIX:
+#if USE_NUMERIC_TOKEN_VALUE
+            if (decimalToInteger(parameter, &value64, sign, sign ? (uint64_t) LONG_MAX : (uint64_t) ULONG_MAX)) {
+                *value = (uint32_t) value64;
+                return TRUE;
+            }
+#endif
             if (sign) {
                 return strBaseToInt32(parameter->ptr, (int32_t *) value, 10) > 0 ? TRUE : FALSE;
             } else {
@@ -826,6 +2287,11 @@ static scpi_bool_t ParamSignToUInt64(scpi_t * context, scpi_parameter_t * parame
             return strBaseToUInt64(parameter->ptr, value, 2) > 0 ? TRUE : FALSE;
         case SCPI_TOKEN_DECIMAL_NUMERIC_PROGRAM_DATA:
         case SCPI_TOKEN_DECIMAL_NUMERIC_PROGRAM_DATA_WITH_SUFFIX:
+#if USE_NUMERIC_TOKEN_VALUE
+            if (decimalToInteger(parameter, value, sign, sign ? 0x7FFFFFFFFFFFFFFFull : 0xFFFFFFFFFFFFFFFFull)) {
+                return TRUE;
+            }
+#endif
             if (sign) {
                 return strBaseToInt64(parameter->ptr, (int64_t *) value, 10) > 0 ? TRUE : FALSE;
             } else {
@@ -905,7 +2371,12 @@ scpi_bool_t SCPI_ParamToFloat(scpi_t * context, scpi_parameter_t * parameter, fl
             break;
         case SCPI_TOKEN_DECIMAL_NUMERIC_PROGRAM_DATA:
         case SCPI_TOKEN_DECIMAL_NUMERIC_PROGRAM_DATA_WITH_SUFFIX:
+#if USE_NUMERIC_TOKEN_VALUE
+            *value = decimalValueToFloat(&parameter->decimal, parameter->ptr);
+            result = TRUE;
+#else
             result = strToFloat(parameter->ptr, value) > 0 ? TRUE : FALSE;
+#endif
             break;
         default:
             result = FALSE;
@@ -938,7 +2409,12 @@ scpi_bool_t SCPI_ParamToDouble(scpi_t * context, scpi_parameter_t * parameter, d
             break;
         case SCPI_TOKEN_DECIMAL_NUMERIC_PROGRAM_DATA:
         case SCPI_TOKEN_DECIMAL_NUMERIC_PROGRAM_DATA_WITH_SUFFIX:
+#if USE_NUMERIC_TOKEN_VALUE
+            *value = decimalValueToDouble(&parameter->decimal, parameter->ptr);
+            result = TRUE;
+#else
             result = strToDouble(parameter->ptr, value) > 0 ? TRUE : FALSE;
+#endif
             break;
         default:
             result = FALSE;
@@ -1246,6 +2722,10 @@ scpi_bool_t SCPI_ParamToChoice(scpi_t * context, scpi_parameter_t * parameter, c
 
     if (parameter->type == SCPI_TOKEN_PROGRAM_MNEMONIC) {
         for (res = 0; options[res].name; ++res) {
+            /* short and long form start with the same letter */
+            if (((options[res].name[0] ^ parameter->ptr[0]) & 0xDF) != 0) {
+                continue;
+            }
             if (matchPattern(options[res].name, strlen(options[res].name), parameter->ptr, parameter->len, NULL)) {
                 *value = options[res].tag;
                 result = TRUE;
@@ -1283,6 +2763,170 @@ scpi_bool_t SCPI_ChoiceToName(const scpi_choice_def_t * options, int32_t tag, co
     return FALSE;
 }
 
+#define CHOICE_TAGS_MASK (2 * SCPI_CHOICE_INDEX_MAX - 1)
+
+/**
+ * Slot of tag in choice index
+ * @param tag
+ * @return first slot to probe
+ */
+static size_t choiceTagSlot(int32_t tag) {
+    return ((uint32_t) tag * 0x9E3779B9UL >> 16) & CHOICE_TAGS_MASK;
+}
+
+/**
+ * Compile choice list to index, so the option is selected by its first
+ * letter and length of the parameter and the name is found by tag without
+ * scanning whole list. The list must not change after compilation.
+ *
+ * @param index storage for the index
+ * @param options - NULL terminated list of choices
+ * @return number of options or 0 if the list has more than
+ * SCPI_CHOICE_INDEX_MAX options or too long names. In that case, the list
+ * is searched linearly.
+ */
+size_t SCPI_CompileChoices(scpi_choice_index_t * index, const scpi_choice_def_t * options) {
+    uint8_t * last[32];
+    size_t len;
+    size_t slot;
+    size_t i;
+
+    if (index == NULL) {
+        return 0;
+    }
+
+    memset(index, 0, sizeof (*index));
+    index->options = options;
+
+    if (options == NULL) {
+        return 0;
+    }
+
+    for (i = 0; i < 32; i++) {
+        last[i] = &index->first[i];
+    }
+
+    for (i = 0; options[i].name != NULL; i++) {
+        if (i >= SCPI_CHOICE_INDEX_MAX) {
+            break;
+        }
+
+        len = strlen(options[i].name);
+        if (len > 255) {
+            break;
+        }
+        if ((len == 0) || (options[i].name[len - 1] != '#')) {
+            index->long_len[i] = (uint8_t) len;
+            index->short_len[i] = (uint8_t) patternSeparatorShortPos(options[i].name, len);
+        }
+
+        /* options of the same letter keep order of the list */
+        *last[options[i].name[0] & 0x1F] = (uint8_t) (i + 1);
+        last[options[i].name[0] & 0x1F] = &index->next[i];
+
+        for (slot = choiceTagSlot(options[i].tag);
+                index->tags[slot] != 0;
+                slot = (slot + 1) & CHOICE_TAGS_MASK) {
+            if (options[index->tags[slot] - 1].tag == options[i].tag) {
+                break;
+            }
+        }
+        if (index->tags[slot] == 0) {
+            index->tags[slot] = (uint8_t) (i + 1);
+        }
+    }
+
+    if (options[i].name != NULL) {
+        /* partially filled index is dropped, only the list is used */
+        memset(index, 0, sizeof (*index));
+        index->options = options;
+        return 0;
+    }
+
+    index->compiled = TRUE;
+    return i;
+}
+
+/**
+ * Convert parameter to choice using compiled choice list
+ * @param context
+ * @param parameter - should be PROGRAM_MNEMONIC
+ * @param index - choice list compiled by SCPI_CompileChoices
+ * @param value - tag of selected option
+ * @return
+ */
+scpi_bool_t SCPI_ParamToChoiceIndex(scpi_t * context, scpi_parameter_t * parameter, const scpi_choice_index_t * index, int32_t * value) {
+    const scpi_choice_def_t * option;
+    size_t len;
+    size_t i;
+
+    if (!index || !index->options || !value) {
+        SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+        return FALSE;
+    }
+
+    if (!index->compiled) {
+        return SCPI_ParamToChoice(context, parameter, index->options, value);
+    }
+
+    if (parameter->type != SCPI_TOKEN_PROGRAM_MNEMONIC) {
+        SCPI_ErrorPush(context, SCPI_ERROR_DATA_TYPE_ERROR);
+        return FALSE;
+    }
+
+    len = parameter->len;
+    for (i = index->first[parameter->ptr[0] & 0x1F]; i != 0; i = index->next[i - 1]) {
+        option = &index->options[i - 1];
+        if (index->long_len[i - 1] == 0) {
+            if (matchPattern(option->name, strlen(option->name), parameter->ptr, len, NULL)) {
+                break;
+            }
+        } else if ((len == index->long_len[i - 1]) || (len == index->short_len[i - 1])) {
+            if (compareStr(option->name, len, parameter->ptr, len)) {
+                break;
+            }
+        }
+    }
+
+    if (i == 0) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return FALSE;
+    }
+
+    *value = index->options[i - 1].tag;
+    return TRUE;
+}
+
+/**
+ * Find tag in compiled choices and returns its first textual representation
+ * @param index choice list compiled by SCPI_CompileChoices
+ * @param tag numerical representatio of choice
+ * @param text result text
+ * @return TRUE if succesfule, else FALSE
+ */
+scpi_bool_t SCPI_ChoiceIndexToName(const scpi_choice_index_t * index, int32_t tag, const char ** text) {
+    size_t slot;
+
+    if (!index || !index->options) {
+        return FALSE;
+    }
+
+    if (!index->compiled) {
+        return SCPI_ChoiceToName(index->options, tag, text);
+    }
+
+    for (slot = choiceTagSlot(tag);
+            index->tags[slot] != 0;
+            slot = (slot + 1) & CHOICE_TAGS_MASK) {
+        if (index->options[index->tags[slot] - 1].tag == tag) {
+            *text = index->options[index->tags[slot] - 1].name;
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
 /*
  * Definition of BOOL choice list
  */
@@ -1351,6 +2995,31 @@ scpi_bool_t SCPI_ParamChoice(scpi_t * context, const scpi_choice_def_t * options
     return result;
 }
 
+/**
+ * Read value from list of options compiled by SCPI_CompileChoices
+ * @param context
+ * @param index
+ * @param value
+ * @param mandatory
+ * @return
+ */
+scpi_bool_t SCPI_ParamChoiceIndex(scpi_t * context, const scpi_choice_index_t * index, int32_t * value, scpi_bool_t mandatory) {
+    scpi_bool_t result;
+    scpi_parameter_t param;
+
+    if (!index || !value) {
+        SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+        return FALSE;
+    }
+
+    result = SCPI_Parameter(context, &param, mandatory);
+    if (result) {
+        result = SCPI_ParamToChoiceIndex(context, &param, index, value);
+    }
+
+    return result;
+}
+
 /**
  * Parse one parameter and detect type
  * @param state
@@ -1373,6 +3042,9 @@ int scpiParser_parseProgramData(lex_state_t * state, scpi_token_t * token) {
             wsLen = scpiLex_WhiteSpace(state, &tmp);
             suffixLen = scpiLex_SuffixProgramData(state, &tmp);
             if (suffixLen > 0) {
+#if USE_NUMERIC_TOKEN_VALUE
+                token->decimal.suffix = token->len + wsLen;
+#endif
                 token->len += wsLen + suffixLen;
                 token->type = SCPI_TOKEN_DECIMAL_NUMERIC_PROGRAM_DATA_WITH_SUFFIX;
                 result = token->len;
@@ -1390,13 +3062,16 @@ int scpiParser_parseProgramData(lex_state_t * state, scpi_token_t * token) {
 }
 
 /**
- * Skip all parameters to correctly detect end of command line.
+ * Skip all parameters to correctly detect end of command line and remember
+ * their tokens.
  * @param state
  * @param token
  * @param numberOfParameters
+ * @param tokens - storage for parameter tokens, can be NULL
+ * @param tokens_len - size of the storage
  * @return
  */
-int scpiParser_parseAllProgramData(lex_state_t * state, scpi_token_t * token, int * numberOfParameters) {
+static int parseAllProgramDataTokens(lex_state_t * state, scpi_token_t * token, int * numberOfParameters, scpi_parameter_token_t * tokens, int tokens_len) {
 
     int result;
     scpi_token_t tmp;
@@ -1419,23 +3094,45 @@ int scpiParser_parseAllProgramData(lex_state_t * state, scpi_token_t * token, in
             paramCount = -1;
             break;
         }
+        if (paramCount < tokens_len) {
+            tokens[paramCount].token = tmp;
+            tokens[paramCount].end = state->pos;
+        }
         paramCount++;
     }
 
+    if (token->type != SCPI_TOKEN_UNKNOWN) {
+        /* whitespace skipped behind number is not part of the returned length */
+        token->len = state->pos - token->ptr;
+    }
+
     if (numberOfParameters != NULL) {
         *numberOfParameters = paramCount;
     }
     return token->len;
 }
 
+/**
+ * Skip all parameters to correctly detect end of command line.
+ * @param state
+ * @param token
+ * @param numberOfParameters
+ * @return
+ */
+int scpiParser_parseAllProgramData(lex_state_t * state, scpi_token_t * token, int * numberOfParameters) {
+    return parseAllProgramDataTokens(state, token, numberOfParameters, NULL, 0);
+}
+
 /**
  * Skip complete command line - program header and parameters
  * @param state
  * @param buffer
  * @param len
+ * @param tokens storage for parameter tokens or NULL
+ * @param tokens_len number of tokens in the storage
  * @return
  */
-int scpiParser_detectProgramMessageUnit(scpi_parser_state_t * state, char * buffer, int len) {
+int scpiParser_detectProgramMessageUnit(scpi_parser_state_t * state, char * buffer, int len, scpi_parameter_token_t * tokens, int tokens_len) {
     lex_state_t lex_state;
     scpi_token_t tmp;
     int result = 0;
@@ -1449,7 +3146,7 @@ int scpiParser_detectProgramMessageUnit(scpi_parser_state_t * state, char * buff
 
     if (scpiLex_ProgramHeader(&lex_state, &state->programHeader) >= 0) {
         if (scpiLex_WhiteSpace(&lex_state, &tmp) > 0) {
-            scpiParser_parseAllProgramData(&lex_state, &state->programData, &state->numberOfParameters);
+            parseAllProgramDataTokens(&lex_state, &state->programData, &state->numberOfParameters, tokens, tokens_len);
         } else {
             invalidateToken(&state->programData, lex_state.pos);
         }
@@ -1565,8 +3262,11 @@ static size_t produceResultArrayBinary(scpi_t * context, const void * array, siz
                 return 0;
         }
     } else {
+        char buffer[SCPI_SWAP_BUFFER_LENGTH];
+        const char * data = (const char *) array;
         size_t result = 0;
-        size_t i;
+        size_t chunk;
+
         switch (item_size) {
             case 1:
             case 2:
@@ -1579,28 +3279,44 @@ static size_t produceResultArrayBinary(scpi_t * context, const void * array, siz
                 return 0;
         }
 
-        switch (item_size) {
-            case 1:
-                result += SCPI_ResultArbitraryBlockData(context, array, count);
-                break;
-            case 2:
-                for (i = 0; i < count; i++) {
-                    uint16_t val = SCPI_Swap16(((uint16_t*) array)[i]);
-                    result += SCPI_ResultArbitraryBlockData(context, &val, item_size);
-                }
-                break;
-            case 4:
-                for (i = 0; i < count; i++) {
-                    uint32_t val = SCPI_Swap32(((uint32_t*) array)[i]);
-                    result += SCPI_ResultArbitraryBlockData(context, &val, item_size);
-                }
-                break;
-            case 8:
-                for (i = 0; i < count; i++) {
-                    uint64_t val = SCPI_Swap64(((uint64_t*) array)[i]);
-                    result += SCPI_ResultArbitraryBlockData(context, &val, item_size);
+        if (item_size == 1) {
+            return result + SCPI_ResultArbitraryBlockData(context, array, count);
+        }
+
+        /* swap bytes directly to the output buffer while there is space */
+        while ((count > 0) && (context->output.length > 0)) {
+            chunk = (context->output.length - context->output.position) / item_size;
+            if (chunk == 0) {
+                writeOutputBuffer(context);
+                chunk = (context->output.length - context->output.position) / item_size;
+                if (chunk == 0) {
+                    break;
                 }
-                break;
+            }
+            if (chunk > count) {
+                chunk = count;
+            }
+            swapArray(context->output.data + context->output.position, data, chunk, item_size);
+            context->output.position += chunk * item_size;
+            context->arbitrary_remaining -= chunk * item_size;
+            if (context->arbitrary_remaining == 0) {
+                context->output_count++;
+            }
+            result += chunk * item_size;
+            data += chunk * item_size;
+            count -= chunk;
+        }
+
+        /* swap bytes in chunks to call write as few times as possible */
+        while (count > 0) {
+            chunk = sizeof (buffer) / item_size;
+            if (chunk > count) {
+                chunk = count;
+            }
+            swapArray(buffer, data, chunk, item_size);
+            result += SCPI_ResultArbitraryBlockData(context, buffer, chunk * item_size);
+            data += chunk * item_size;
+            count -= chunk;
         }
 
         return result;
@@ -1741,11 +3457,60 @@ size_t SCPI_ResultArrayDouble(scpi_t * context, const double * array, size_t cou
     RESULT_ARRAY(SCPI_ResultDouble);
 }
 
+/**
+ * Read binary array from arbitrary block and swap bytes if needed
+ * (native endiannes != required endiannes)
+ * @param context
+ * @param data - array to fill
+ * @param item_size - size of one element
+ * @param i_count - number of elements of data
+ * @param o_count - real number of filled elements
+ * @param format
+ * @param mandatory
+ * @return TRUE on success
+ */
+static scpi_bool_t paramArrayBinary(scpi_t * context, void * data, size_t item_size, size_t i_count, size_t * o_count, scpi_array_format_t format, scpi_bool_t mandatory) {
+    scpi_parameter_t param;
+    size_t count;
+
+    *o_count = 0;
+
+    if ((format != SCPI_FORMAT_NORMAL) && (format != SCPI_FORMAT_SWAPPED)) {
+        return FALSE;
+    }
+
+    if (!SCPI_Parameter(context, &param, mandatory)) {
+        return mandatory ? FALSE : TRUE;
+    }
+
+    if (param.type != SCPI_TOKEN_ARBITRARY_BLOCK_PROGRAM_DATA) {
+        SCPI_ErrorPush(context, SCPI_ERROR_DATA_TYPE_ERROR);
+        return FALSE;
+    }
+
+    count = param.len / item_size;
+    if ((param.len % item_size) || (count > i_count)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return FALSE;
+    }
+
+    if (SCPI_GetNativeFormat() == format) {
+        memcpy(data, param.ptr, param.len);
+    } else {
+        swapArray(data, param.ptr, count, item_size);
+    }
+    *o_count = count;
+
+    return TRUE;
+}
+
 /*
  * Template macro to generate all SCPI_ParamArrayXYZ function
  */
 #define PARAM_ARRAY_TEMPLATE(func) do{\
-    if (format != SCPI_FORMAT_ASCII) return FALSE;\
+    if (format != SCPI_FORMAT_ASCII) {\
+        return paramArrayBinary(context, data, sizeof(*data), i_count, o_count, format, mandatory);\
+    }\
     for (*o_count = 0; *o_count < i_count; (*o_count)++) {\
         if (!func(context, &data[*o_count], mandatory)) {\
             break;\
@@ -286,20 +286,140 @@ const scpi_choice_def_t scpi_special_numbers_def[] = {
     SCPI_CHOICE_LIST_END,
 };
 
+#define UNITS_INDEX_MASK (SCPI_UNITS_INDEX_SIZE - 1)
+
+/**
+ * Slot of unit in inverse index
+ * @param unit
+ * @return first slot to probe
+ */
+static size_t unitSlot(scpi_unit_t unit) {
+    return ((uint32_t) unit * 0x9E3779B9UL >> 16) & UNITS_INDEX_MASK;
+}
+
+/**
+ * Build hash index of unit definitions, so suffix of every number and
+ * unit of every formatted number is found without scanning whole table.
+ *
+ * Index is valid for units table set in SCPI_DefinitionInit, definitions
+ * are found exactly as by the linear search: the first one of the same
+ * name and the first one with multiplier 1 for formatting.
+ *
+ * @param definition
+ * @param index storage for the index
+ * @return number of indexed definitions or 0 if the table does not fit in
+ * SCPI_UNITS_INDEX_SIZE. In that case, the table is searched linearly.
+ */
+size_t SCPI_DefinitionCompileUnits(scpi_definition_t * definition, scpi_unit_index_t * index) {
+    size_t i;
+    size_t slot;
+    size_t len;
+    const scpi_unit_def_t * units;
+
+    if (definition == NULL) {
+        return 0;
+    }
+
+    definition->units_index = NULL;
+    units = definition->units;
+
+    if ((index == NULL) || (units == NULL)) {
+        return 0;
+    }
+
+    memset(index, 0, sizeof (*index));
+    index->units = units;
+
+    for (i = 0; units[i].name != NULL; i++) {
+        /* keep at least one empty slot to terminate probing */
+        if (i + 1 >= SCPI_UNITS_INDEX_SIZE) {
+            return 0;
+        }
+
+        len = strlen(units[i].name);
+        for (slot = hashName(units[i].name, len) & UNITS_INDEX_MASK;
+                index->names[slot] != 0;
+                slot = (slot + 1) & UNITS_INDEX_MASK) {
+            if (compareStr(units[i].name, len, units[index->names[slot] - 1].name, strlen(units[index->names[slot] - 1].name))) {
+                break;
+            }
+        }
+        if (index->names[slot] == 0) {
+            index->names[slot] = (uint16_t) (i + 1);
+        }
+
+        if (units[i].mult != 1) {
+            continue;
+        }
+        for (slot = unitSlot(units[i].unit);
+                index->inverse[slot] != 0;
+                slot = (slot + 1) & UNITS_INDEX_MASK) {
+            if (units[index->inverse[slot] - 1].unit == units[i].unit) {
+                break;
+            }
+        }
+        if (index->inverse[slot] == 0) {
+            index->inverse[slot] = (uint16_t) (i + 1);
+        }
+    }
+
+    definition->units_index = index;
+    return i;
+}
+
+#if USE_SESSION_DEFINITION
+/**
+ * Build unit index for units table of the context set by SCPI_Init
+ * @param context
+ * @param index storage for the index
+ * @return number of indexed definitions or 0. Shared definition of the
+ * session is not changed, SCPI_ERROR_SYSTEM_ERROR is pushed instead. It is
+ * compiled by SCPI_DefinitionCompileUnits.
+ */
+size_t SCPI_CompileUnits(scpi_t * context, scpi_unit_index_t * index) {
+    if (context == NULL) {
+        return 0;
+    }
+
+    if (context->definition != &context->local_definition) {
+        SCPI_ErrorPush(context, SCPI_ERROR_SYSTEM_ERROR);
+        return 0;
+    }
+
+    return SCPI_DefinitionCompileUnits(&context->local_definition, index);
+}
+#endif
+
 /**
  * Convert string describing unit to its representation
- * @param units units patterns
+ * @param context
  * @param unit text representation of unknown unit
  * @param len length of text representation
  * @return pointer of related unit definition or NULL
  */
-static const scpi_unit_def_t * translateUnit(const scpi_unit_def_t * units, const char * unit, size_t len) {
+static const scpi_unit_def_t * translateUnit(scpi_t * context, const char * unit, size_t len) {
+    const scpi_unit_def_t * units = context->definition->units;
+    const scpi_unit_index_t * index = context->definition->units_index;
+    const scpi_unit_def_t * def;
+    size_t slot;
     int i;
 
     if (units == NULL) {
         return NULL;
     }
 
+    if ((index != NULL) && (index->units == units)) {
+        for (slot = hashName(unit, len) & UNITS_INDEX_MASK;
+                index->names[slot] != 0;
+                slot = (slot + 1) & UNITS_INDEX_MASK) {
+            def = &units[index->names[slot] - 1];
+            if (compareStr(unit, len, def->name, strlen(def->name))) {
+                return def;
+            }
+        }
+        return NULL;
+    }
+
     for (i = 0; units[i].name != NULL; i++) {
         if (compareStr(unit, len, units[i].name, strlen(units[i].name))) {
             return &units[i];
@@ -311,17 +431,31 @@ static const scpi_unit_def_t * translateUnit(const scpi_unit_def_t * units, cons
 
 /**
  * Convert unit definition to string
- * @param units units definitions (patterns)
+ * @param context
  * @param unit type of unit
  * @return string representation of unit
  */
-static const char * translateUnitInverse(const scpi_unit_def_t * units, const scpi_unit_t unit) {
+static const char * translateUnitInverse(scpi_t * context, const scpi_unit_t unit) {
+    const scpi_unit_def_t * units = context->definition->units;
+    const scpi_unit_index_t * index = context->definition->units_index;
+    size_t slot;
     int i;
 
     if (units == NULL) {
         return NULL;
     }
 
+    if ((index != NULL) && (index->units == units)) {
+        for (slot = unitSlot(unit);
+                index->inverse[slot] != 0;
+                slot = (slot + 1) & UNITS_INDEX_MASK) {
+            if (units[index->inverse[slot] - 1].unit == unit) {
+                return units[index->inverse[slot] - 1].name;
+            }
+        }
+        return NULL;
+    }
+
     for (i = 0; units[i].name != NULL; i++) {
         if ((units[i].unit == unit) && (units[i].mult == 1)) {
             return units[i].name;
@@ -349,7 +483,7 @@ static scpi_bool_t transformNumber(scpi_t * context, const char * unit, size_t l
         return TRUE;
     }
 
-    unitDef = translateUnit(context->units, unit + s, len - s);
+    unitDef = translateUnit(context, unit + s, len - s);
 
     if (unitDef == NULL) {
         SCPI_ErrorPush(context, SCPI_ERROR_INVALID_SUFFIX);
@@ -439,9 +573,14 @@ scpi_bool_t SCPI_ParamNumber(scpi_t * context, const scpi_choice_def_t * special
             SCPI_ParamToDouble(context, &param, &(value->content.value));
             break;
         case SCPI_TOKEN_DECIMAL_NUMERIC_PROGRAM_DATA_WITH_SUFFIX:
+#if USE_NUMERIC_TOKEN_VALUE
+            token.ptr = param.ptr + param.decimal.suffix;
+            token.len = param.len - param.decimal.suffix;
+#else
             scpiLex_DecimalNumericProgramData(&state, &token);
             scpiLex_WhiteSpace(&state, &token);
             scpiLex_SuffixProgramData(&state, &token);
+#endif
 
             SCPI_ParamToDouble(context, &param, &(value->content.value));
 
@@ -497,7 +636,7 @@ size_t SCPI_NumberToStr(scpi_t * context, const scpi_choice_def_t * special, scp
     result = SCPI_DoubleToStr(value->content.value, str, len);
 
     if (result + 1 < len) {
-        unit = translateUnitInverse(context->units, value->unit);
+        unit = translateUnitInverse(context, value->unit);
 
         if (unit) {
             strncat(str, " ", len - result);
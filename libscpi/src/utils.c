@@ -42,9 +42,22 @@
 #include <math.h>
 
 #include "utils_private.h"
+#include "dtoa_private.h"
+#include "strtod_private.h"
 #include "scpi/utils.h"
 
-static size_t patternSeparatorShortPos(const char * pattern, size_t len);
+#if HAVE_AVX2
+#include <immintrin.h>
+#elif HAVE_SSSE3
+#include <tmmintrin.h>
+#elif HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+#if HAVE_NEON
+#include <arm_neon.h>
+#endif
+
 static size_t patternSeparatorPos(const char * pattern, size_t len);
 static size_t cmdSeparatorPos(const char * cmd, size_t len);
 
@@ -319,9 +332,13 @@ size_t strBaseToUInt64(const char * str, uint64_t * val, int8_t base) {
  * @return      number of bytes used in string
  */
 size_t strToFloat(const char * str, float * val) {
+#if USE_FAST_STRTOD
+    return decimalToFloat(str, val);
+#else
     char * endptr;
     *val = SCPIDEFINE_strtof(str, &endptr);
     return endptr - str;
+#endif
 }
 
 /**
@@ -331,9 +348,13 @@ size_t strToFloat(const char * str, float * val) {
  * @return      number of bytes used in string
  */
 size_t strToDouble(const char * str, double * val) {
+#if USE_FAST_STRTOD
+    return decimalToDouble(str, val);
+#else
     char * endptr;
     *val = strtod(str, &endptr);
     return endptr - str;
+#endif
 }
 
 /**
@@ -423,7 +444,7 @@ size_t skipWhitespace(const char * cmd, size_t len) {
  * @param len - max search length
  * @return position of separator or len
  */
-static size_t patternSeparatorShortPos(const char * pattern, size_t len) {
+size_t patternSeparatorShortPos(const char * pattern, size_t len) {
     size_t i;
     for (i = 0; (i < len) && pattern[i]; i++) {
         if (islower((unsigned char) pattern[i])) {
@@ -711,6 +732,102 @@ scpi_bool_t composeCompoundCommand(const scpi_token_t * prev, scpi_token_t * cur
     return TRUE;
 }
 
+#define HASH_FNV_PRIME 16777619UL
+#define HASH_GOLDEN 0x9E3779B9UL
+
+/**
+ * Final mixing of hash value (MurmurHash3 finalizer)
+ * @param h
+ * @return mixed hash
+ */
+static uint32_t hashMix(uint32_t h) {
+    h ^= h >> 16;
+    h *= 0x85EBCA6BUL;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35UL;
+    h ^= h >> 16;
+    return h;
+}
+
+/**
+ * Compute two independent hashes of command header for lookup in
+ * precompiled command tables. Header is normalized in the same way as it
+ * is compared to patterns: case is ignored, leading ':' is skipped and
+ * numeric suffix of mnemonic is not part of the hash.
+ *
+ * @param header command header, e.g. "SYST:ERR?" or "OUTPut2:STATe"
+ * @param len length of the header
+ * @param h1 first hash, selects bucket
+ * @param h2 second hash, selects slot together with bucket displacement
+ */
+void hashCommandHeader(const char * header, size_t len, uint32_t * h1, uint32_t * h2) {
+    uint32_t a = 2166136261UL;
+    uint32_t b = 0x3C6EF372UL;
+    size_t i;
+    size_t digits = 0;
+    uint32_t hashed = 0;
+    unsigned char c;
+
+    if ((len > 0) && (header[0] == ':')) {
+        header++;
+        len--;
+    }
+
+    for (i = 0; i < len; i++) {
+        c = (unsigned char) header[i];
+        if (isdigit(c)) {
+            digits++;
+            continue;
+        }
+
+        if ((c != ':') && (c != '?')) {
+            /* digits inside of mnemonic are part of it */
+            for (; digits > 0; digits--) {
+                a = (a ^ (unsigned char) header[i - digits]) * HASH_FNV_PRIME;
+                b = (b + (unsigned char) header[i - digits]) * HASH_GOLDEN;
+                hashed++;
+            }
+        }
+        digits = 0;
+
+        c = (unsigned char) toupper(c);
+        a = (a ^ c) * HASH_FNV_PRIME;
+        b = (b + c) * HASH_GOLDEN;
+        hashed++;
+    }
+
+    *h1 = hashMix(a);
+    *h2 = hashMix(b ^ hashed);
+}
+
+/**
+ * Compute slot in precompiled command table
+ * @param h2 second hash of the header
+ * @param displacement displacement of the bucket
+ * @param size number of slots
+ * @return slot index
+ */
+uint32_t hashCommandSlot(uint32_t h2, uint32_t displacement, uint32_t size) {
+    return hashMix(h2 + displacement * HASH_GOLDEN) % size;
+}
+
+/**
+ * Compute hash of a name ignoring its case, e.g. of unit suffix
+ * @param name
+ * @param len length of the name
+ * @return hash value
+ */
+uint32_t hashName(const char * name, size_t len) {
+    uint32_t h = 2166136261UL;
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        h = (h ^ (unsigned char) toupper((unsigned char) name[i])) * HASH_FNV_PRIME;
+    }
+
+    return hashMix(h);
+}
+
 
 
 #if !HAVE_STRNLEN
@@ -1140,3 +1257,136 @@ uint64_t SCPI_Swap64(uint64_t val) {
             ((val & 0x00FF000000000000ull) >> 40) |
             ((val & 0xFF00000000000000ull) >> 56);
 }
+
+#if HAVE_SSSE3
+/* byte order of one 16 byte vector for item size 2, 4 and 8 */
+static const char swap_shuffle[3][16] = {
+    {1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14},
+    {3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12},
+    {7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8},
+};
+#endif
+
+/**
+ * Swap bytes of whole vectors of the array
+ * @param dst - destination array
+ * @param src - source array
+ * @param len - length of the array in bytes
+ * @param item_size - size of item in bytes (2, 4 or 8)
+ * @return number of processed bytes
+ */
+static size_t swapArrayVector(char * dst, const char * src, size_t len, size_t item_size) {
+    size_t i = 0;
+
+#if HAVE_SSSE3
+    const char * shuffle = swap_shuffle[item_size == 2 ? 0 : (item_size == 4 ? 1 : 2)];
+    __m128i mask = _mm_loadu_si128((const __m128i *) shuffle);
+#if HAVE_AVX2
+    __m256i mask256 = _mm256_broadcastsi128_si256(mask);
+
+    for (; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *) (src + i));
+        _mm256_storeu_si256((__m256i *) (dst + i), _mm256_shuffle_epi8(v, mask256));
+    }
+#endif
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (src + i));
+        _mm_storeu_si128((__m128i *) (dst + i), _mm_shuffle_epi8(v, mask));
+    }
+#elif HAVE_SSE2
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (src + i));
+        /* swap bytes of 16bit words, then reorder words of bigger items */
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        switch (item_size) {
+            case 2:
+                break;
+            case 4:
+                v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+                v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+                break;
+            default:
+                v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+                v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+                break;
+        }
+        _mm_storeu_si128((__m128i *) (dst + i), v);
+    }
+#elif HAVE_NEON
+    for (; i + 16 <= len; i += 16) {
+        uint8x16_t v = vld1q_u8((const uint8_t *) (src + i));
+        switch (item_size) {
+            case 2:
+                v = vrev16q_u8(v);
+                break;
+            case 4:
+                v = vrev32q_u8(v);
+                break;
+            default:
+                v = vrev64q_u8(v);
+                break;
+        }
+        vst1q_u8((uint8_t *) (dst + i), v);
+    }
+#else
+    (void) dst;
+    (void) src;
+    (void) len;
+    (void) item_size;
+#endif
+
+    return i;
+}
+
+/**
+ * Copy array of numbers and swap bytes of each of them. Source and
+ * destination do not have to be aligned, they can be the same array.
+ * Vector instructions (SSE2, SSSE3, AVX2 or NEON) are used if they are
+ * available.
+ * @param dst - destination array
+ * @param src - source array
+ * @param count - number of items
+ * @param item_size - size of item in bytes (1, 2, 4 or 8)
+ */
+void swapArray(void * dst, const void * src, size_t count, size_t item_size) {
+    char * d = (char *) dst;
+    const char * s = (const char *) src;
+    size_t i;
+
+    if ((item_size == 2) || (item_size == 4) || (item_size == 8)) {
+        i = swapArrayVector(d, s, count * item_size, item_size);
+        d += i;
+        s += i;
+        count -= i / item_size;
+    }
+
+    switch (item_size) {
+        case 2:
+            for (i = 0; i < count; i++, d += 2, s += 2) {
+                uint16_t val;
+                memcpy(&val, s, sizeof (val));
+                val = SCPI_Swap16(val);
+                memcpy(d, &val, sizeof (val));
+            }
+            break;
+        case 4:
+            for (i = 0; i < count; i++, d += 4, s += 4) {
+                uint32_t val;
+                memcpy(&val, s, sizeof (val));
+                val = SCPI_Swap32(val);
+                memcpy(d, &val, sizeof (val));
+            }
+            break;
+        case 8:
+            for (i = 0; i < count; i++, d += 8, s += 8) {
+                uint64_t val;
+                memcpy(&val, s, sizeof (val));
+                val = SCPI_Swap64(val);
+                memcpy(d, &val, sizeof (val));
+            }
+            break;
+        default:
+            memmove(d, s, count * item_size);
+            break;
+    }
+}
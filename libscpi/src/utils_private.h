@@ -66,9 +66,13 @@ extern "C" {
     scpi_bool_t locateText(const char * str1, size_t len1, const char ** str2, size_t * len2) LOCAL;
     scpi_bool_t locateStr(const char * str1, size_t len1, const char ** str2, size_t * len2) LOCAL;
     size_t skipWhitespace(const char * cmd, size_t len) LOCAL;
+    size_t patternSeparatorShortPos(const char * pattern, size_t len) LOCAL;
     scpi_bool_t matchPattern(const char * pattern, size_t pattern_len, const char * str, size_t str_len, int32_t * num) LOCAL;
     scpi_bool_t matchCommand(const char * pattern, const char * cmd, size_t len, int32_t *numbers, size_t numbers_len, int32_t default_value) LOCAL;
     scpi_bool_t composeCompoundCommand(const scpi_token_t * prev, scpi_token_t * current) LOCAL;
+    void hashCommandHeader(const char * header, size_t len, uint32_t * h1, uint32_t * h2) LOCAL;
+    uint32_t hashCommandSlot(uint32_t h2, uint32_t displacement, uint32_t size) LOCAL;
+    uint32_t hashName(const char * name, size_t len) LOCAL;
 
 #define SCPI_DTOSTRE_UPPERCASE   1
 #define SCPI_DTOSTRE_ALWAYS_SIGN 2
@@ -79,6 +83,7 @@ extern "C" {
     uint16_t SCPI_Swap16(uint16_t val);
     uint32_t SCPI_Swap32(uint32_t val);
     uint64_t SCPI_Swap64(uint64_t val);
+    void swapArray(void * dst, const void * src, size_t count, size_t item_size) LOCAL;
 
 #if !HAVE_STRNLEN
     size_t BSD_strnlen(const char *s, size_t maxlen) LOCAL;
@@ -32,6 +32,12 @@
 
 #include "../src/fifo_private.h"
 
+#if USE_LOCKFREE_ERROR_QUEUE
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 /*
  * CUnit Test Suite
  */
@@ -44,19 +50,19 @@ static int clean_suite(void) {
     return 0;
 }
 
-static void testFifo() {
-    scpi_fifo_t fifo;
-    scpi_error_t fifo_data[4];
-    fifo_init(&fifo, fifo_data, 4);
-    scpi_error_t value;
-    int16_t count_value;
-
 #define TEST_FIFO_COUNT(n)                      \
     do {                                        \
         fifo_count(&fifo, &count_value);        \
         CU_ASSERT_EQUAL(count_value, n);        \
     } while(0)                                  \
 
+static void testFifo() {
+    scpi_fifo_t fifo;
+    scpi_error_t fifo_data[4];
+    fifo_init(&fifo, fifo_data, 4);
+    scpi_error_t value;
+    int16_t count_value;
+    int16_t fourth;
 
     TEST_FIFO_COUNT(0);
     CU_ASSERT_TRUE(fifo_is_empty(&fifo));
@@ -102,6 +108,12 @@ static void testFifo() {
     CU_ASSERT_EQUAL(fifo.data[2].error_code, 3);
     CU_ASSERT_EQUAL(fifo.data[3].error_code, 4);
 
+#if USE_LOCKFREE_ERROR_QUEUE
+    /* last element can not be taken back, other threads may add */
+    CU_ASSERT_FALSE(fifo_remove_last(&fifo, &value));
+    TEST_FIFO_COUNT(4);
+    fourth = 4;
+#else
     CU_ASSERT_TRUE(fifo_remove_last(&fifo, &value));
     CU_ASSERT_EQUAL(value.error_code, 4);
     TEST_FIFO_COUNT(3);
@@ -113,11 +125,13 @@ static void testFifo() {
     TEST_FIFO_COUNT(4);
     CU_ASSERT_FALSE(fifo_is_empty(&fifo));
     CU_ASSERT_TRUE(fifo_is_full(&fifo));
+    fourth = 6;
+#endif
 
     CU_ASSERT_EQUAL(fifo.data[0].error_code, 1);
     CU_ASSERT_EQUAL(fifo.data[1].error_code, 2);
     CU_ASSERT_EQUAL(fifo.data[2].error_code, 3);
-    CU_ASSERT_EQUAL(fifo.data[3].error_code, 6);
+    CU_ASSERT_EQUAL(fifo.data[3].error_code, fourth);
 
     CU_ASSERT_TRUE(fifo_remove(&fifo, &value));
     CU_ASSERT_EQUAL(value.error_code, 1);
@@ -146,13 +160,25 @@ static void testFifo() {
     TEST_FIFO_COUNT(4);
 
     CU_ASSERT_TRUE(fifo_remove(&fifo, &value));
-    CU_ASSERT_EQUAL(value.error_code, 6);
+    CU_ASSERT_EQUAL(value.error_code, fourth);
     TEST_FIFO_COUNT(3);
 
     CU_ASSERT_TRUE(fifo_remove(&fifo, &value));
     CU_ASSERT_EQUAL(value.error_code, 7);
     TEST_FIFO_COUNT(2);
 
+#if USE_LOCKFREE_ERROR_QUEUE
+    CU_ASSERT_FALSE(fifo_remove_last(&fifo, &value));
+    TEST_FIFO_COUNT(2);
+
+    CU_ASSERT_TRUE(fifo_remove(&fifo, &value));
+    CU_ASSERT_EQUAL(value.error_code, 10);
+    TEST_FIFO_COUNT(1);
+
+    CU_ASSERT_TRUE(fifo_remove(&fifo, &value));
+    CU_ASSERT_EQUAL(value.error_code, 11);
+    TEST_FIFO_COUNT(0);
+#else
     CU_ASSERT_TRUE(fifo_remove_last(&fifo, &value));
     CU_ASSERT_EQUAL(value.error_code, 11);
     TEST_FIFO_COUNT(1);
@@ -160,6 +186,7 @@ static void testFifo() {
     CU_ASSERT_TRUE(fifo_remove(&fifo, &value));
     CU_ASSERT_EQUAL(value.error_code, 10);
     TEST_FIFO_COUNT(0);
+#endif
 
     CU_ASSERT_FALSE(fifo_remove(&fifo, &value));
     TEST_FIFO_COUNT(0);
@@ -167,6 +194,158 @@ static void testFifo() {
     CU_ASSERT_FALSE(fifo_remove_last(&fifo, NULL));
 }
 
+static void testFifoAddLast() {
+    scpi_fifo_t fifo;
+    scpi_error_t fifo_data[4];
+    scpi_error_t value;
+    scpi_error_t last;
+    int16_t count_value;
+    int16_t i;
+
+    fifo_init(&fifo, fifo_data, 4);
+    last.error_code = -350;
+
+    value.error_code = 1;
+    CU_ASSERT_TRUE(fifo_add_last(&fifo, &value, &last));
+    value.error_code = 2;
+    CU_ASSERT_TRUE(fifo_add_last(&fifo, &value, &last));
+    value.error_code = 3;
+    CU_ASSERT_TRUE(fifo_add_last(&fifo, &value, &last));
+    TEST_FIFO_COUNT(3);
+    CU_ASSERT_FALSE(fifo_is_full(&fifo));
+
+    /* last place gets the last element */
+    value.error_code = 4;
+    CU_ASSERT_FALSE(fifo_add_last(&fifo, &value, &last));
+    TEST_FIFO_COUNT(4);
+    CU_ASSERT_TRUE(fifo_is_full(&fifo));
+
+    value.error_code = 5;
+    CU_ASSERT_FALSE(fifo_add_last(&fifo, &value, &last));
+    TEST_FIFO_COUNT(4);
+
+    CU_ASSERT_TRUE(fifo_remove(&fifo, &value));
+    CU_ASSERT_EQUAL(value.error_code, 1);
+    CU_ASSERT_TRUE(fifo_remove(&fifo, &value));
+    CU_ASSERT_EQUAL(value.error_code, 2);
+    CU_ASSERT_TRUE(fifo_remove(&fifo, &value));
+    CU_ASSERT_EQUAL(value.error_code, 3);
+    CU_ASSERT_TRUE(fifo_remove(&fifo, &value));
+    CU_ASSERT_EQUAL(value.error_code, -350);
+    CU_ASSERT_FALSE(fifo_remove(&fifo, &value));
+    CU_ASSERT_TRUE(fifo_is_empty(&fifo));
+
+    /* positions wrap around */
+    for (i = 1; i <= 20; i++) {
+        value.error_code = i;
+        CU_ASSERT_TRUE(fifo_add(&fifo, &value));
+        value.error_code = i + 100;
+        CU_ASSERT_TRUE(fifo_add(&fifo, &value));
+        CU_ASSERT_TRUE(fifo_remove(&fifo, &value));
+        CU_ASSERT_EQUAL(value.error_code, i);
+        CU_ASSERT_TRUE(fifo_remove(&fifo, &value));
+        CU_ASSERT_EQUAL(value.error_code, i + 100);
+        TEST_FIFO_COUNT(0);
+    }
+}
+
+#if USE_LOCKFREE_ERROR_QUEUE
+static void testFifoWrap() {
+    scpi_fifo_t fifo;
+    scpi_error_t fifo_data[3];
+    scpi_error_t value;
+    int16_t count_value;
+    int16_t i;
+
+    fifo_init(&fifo, fifo_data, 3);
+
+    /* positions wrap at the biggest multiple of size */
+    fifo.wr = 0xFFFFFFFDul;
+    fifo.rd = 0xFFFFFFFDul;
+    for (i = 1; i <= 3; i++) {
+        value.error_code = i;
+        CU_ASSERT_TRUE(fifo_add(&fifo, &value));
+    }
+    TEST_FIFO_COUNT(3);
+    CU_ASSERT_TRUE(fifo_is_full(&fifo));
+    CU_ASSERT_EQUAL(fifo.wr, 1);
+
+    value.error_code = 4;
+    CU_ASSERT_FALSE(fifo_add(&fifo, &value));
+
+    for (i = 1; i <= 3; i++) {
+        CU_ASSERT_TRUE(fifo_remove(&fifo, &value));
+        CU_ASSERT_EQUAL(value.error_code, i);
+    }
+    TEST_FIFO_COUNT(0);
+    CU_ASSERT_TRUE(fifo_is_empty(&fifo));
+}
+
+#define TEST_THREADS 4
+#define TEST_THREAD_ITEMS 50000
+
+static scpi_fifo_t thread_fifo;
+
+static void * fifoProducer(void * arg) {
+    int16_t id = (int16_t) (intptr_t) arg;
+    scpi_error_t value;
+    long i;
+
+    for (i = 0; i < TEST_THREAD_ITEMS; i++) {
+        value.error_code = (int16_t) (id * 1000 + i % 1000 + 1);
+        while (!fifo_add(&thread_fifo, &value)) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void testFifoThreads() {
+    scpi_error_t fifo_data[5];
+    scpi_error_t value;
+    pthread_t threads[TEST_THREADS];
+    long expected[TEST_THREADS];
+    long received = 0;
+    long wrong = 0;
+    int16_t count;
+    int16_t id;
+    int i;
+
+    fifo_init(&thread_fifo, fifo_data, 5);
+    for (i = 0; i < TEST_THREADS; i++) {
+        expected[i] = 0;
+        CU_ASSERT_EQUAL(pthread_create(&threads[i], NULL, fifoProducer, (void *) (intptr_t) i), 0);
+    }
+
+    /* every element comes exactly once and in order of its producer */
+    while (received < TEST_THREADS * (long) TEST_THREAD_ITEMS) {
+        fifo_count(&thread_fifo, &count);
+        if ((count < 0) || (count > 5)) {
+            wrong++;
+        }
+        if (!fifo_remove(&thread_fifo, &value)) {
+            sched_yield();
+            continue;
+        }
+        id = (int16_t) ((value.error_code - 1) / 1000);
+        if ((id < 0) || (id >= TEST_THREADS)
+                || (value.error_code != id * 1000 + expected[id] % 1000 + 1)) {
+            wrong++;
+        } else {
+            expected[id]++;
+        }
+        received++;
+    }
+
+    for (i = 0; i < TEST_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+        CU_ASSERT_EQUAL(expected[i], TEST_THREAD_ITEMS);
+    }
+    CU_ASSERT_EQUAL(wrong, 0);
+    CU_ASSERT_TRUE(fifo_is_empty(&thread_fifo));
+}
+#endif
+
 int main() {
     unsigned int result;
     CU_pSuite pSuite = NULL;
@@ -183,7 +362,12 @@ int main() {
     }
 
     /* Add the tests to the suite */
-    if ((NULL == CU_add_test(pSuite, "test fifo", testFifo))) {
+    if ((NULL == CU_add_test(pSuite, "test fifo", testFifo))
+#if USE_LOCKFREE_ERROR_QUEUE
+            || (NULL == CU_add_test(pSuite, "test fifo wrap", testFifoWrap))
+            || (NULL == CU_add_test(pSuite, "test fifo threads", testFifoThreads))
+#endif
+            || (NULL == CU_add_test(pSuite, "test fifo add last", testFifoAddLast))) {
         CU_cleanup_registry();
         return CU_get_error();
     }
@@ -28,6 +28,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <ctype.h>
 #include "CUnit/Basic.h"
 
 #include "../src/lexer_private.h"
@@ -122,6 +123,79 @@ static void TEST_TOKEN(const char * str, lexfn_t fn, int offset, int len, scpi_t
     if (len != token.len) printToken(&token);   \
 } while(0)
 
+static void testCharClass(void) {
+    int c;
+
+    /* table must agree with C locale classification */
+    for (c = 0; c < 256; c++) {
+        CU_ASSERT_EQUAL(scpiLex_IsCharClass(c, SCPI_CHAR_DIGIT), c < 0x80 && isdigit(c));
+        CU_ASSERT_EQUAL(scpiLex_IsCharClass(c, SCPI_CHAR_ALPHA), c < 0x80 && isalpha(c));
+        CU_ASSERT_EQUAL(scpiLex_IsCharClass(c, SCPI_CHAR_XDIGIT), c < 0x80 && isxdigit(c));
+        CU_ASSERT_EQUAL(scpiLex_IsCharClass(c, SCPI_CHAR_MNEMONIC), c < 0x80 && (isalnum(c) || c == '_'));
+        CU_ASSERT_EQUAL(scpiLex_IsCharClass(c, SCPI_CHAR_STRING), c < 0x80);
+        CU_ASSERT_EQUAL(scpiLex_IsCharClass(c, SCPI_CHAR_EXPRESSION), c >= 0x20 && c <= 0x7e && !strchr("\"#'();", c));
+    }
+
+    CU_ASSERT_TRUE(scpiLex_IsCharClass(' ', SCPI_CHAR_WS));
+    CU_ASSERT_TRUE(scpiLex_IsCharClass('\t', SCPI_CHAR_WS));
+    CU_ASSERT_FALSE(scpiLex_IsCharClass('\n', SCPI_CHAR_WS));
+    CU_ASSERT_TRUE(scpiLex_IsCharClass('\n', SCPI_CHAR_TERMINATOR));
+    CU_ASSERT_TRUE(scpiLex_IsCharClass('\r', SCPI_CHAR_TERMINATOR));
+    CU_ASSERT_TRUE(scpiLex_IsCharClass('7', SCPI_CHAR_OCTDIGIT));
+    CU_ASSERT_FALSE(scpiLex_IsCharClass('8', SCPI_CHAR_OCTDIGIT));
+    CU_ASSERT_TRUE(scpiLex_IsCharClass('1', SCPI_CHAR_BINDIGIT));
+    CU_ASSERT_FALSE(scpiLex_IsCharClass('2', SCPI_CHAR_BINDIGIT));
+    CU_ASSERT_TRUE(scpiLex_IsCharClass('\'', SCPI_CHAR_QUOTE));
+    CU_ASSERT_TRUE(scpiLex_IsCharClass('-', SCPI_CHAR_SIGN));
+    CU_ASSERT_TRUE(scpiLex_IsCharClass('e', SCPI_CHAR_EXPONENT));
+    CU_ASSERT_TRUE(scpiLex_IsCharClass('*', SCPI_CHAR_HEADER_START));
+    CU_ASSERT_FALSE(scpiLex_IsCharClass('?', SCPI_CHAR_HEADER_START));
+    CU_ASSERT_TRUE(scpiLex_IsCharClass('?', SCPI_CHAR_HEADER));
+    CU_ASSERT_FALSE(scpiLex_IsCharClass(0xC1, SCPI_CHAR_HEADER));
+}
+
+static void testSpan(void) {
+    char str[100];
+    size_t i;
+
+    /* stop character at every position of vector */
+    for (i = 0; i < 70; i++) {
+        memset(str, 'a', sizeof (str));
+        str[i] = '"';
+        CU_ASSERT_EQUAL(scpiLex_SpanString(str, sizeof (str), '"'), i);
+        CU_ASSERT_EQUAL(scpiLex_SpanString(str, sizeof (str), '\''), sizeof (str));
+        str[i] = (char) 0xC3;
+        CU_ASSERT_EQUAL(scpiLex_SpanString(str, sizeof (str), '"'), i);
+        CU_ASSERT_EQUAL(scpiLex_SpanStringLine(str, sizeof (str), '"'), i);
+        str[i] = '\n';
+        CU_ASSERT_EQUAL(scpiLex_SpanString(str, sizeof (str), '"'), sizeof (str));
+        CU_ASSERT_EQUAL(scpiLex_SpanStringLine(str, sizeof (str), '"'), i);
+        str[i] = '\r';
+        CU_ASSERT_EQUAL(scpiLex_SpanStringLine(str, sizeof (str), '\''), i);
+
+        memset(str, '+', sizeof (str));
+        str[i] = ')';
+        CU_ASSERT_EQUAL(scpiLex_SpanExpression(str, sizeof (str)), i);
+        str[i] = '\t';
+        CU_ASSERT_EQUAL(scpiLex_SpanExpression(str, sizeof (str)), i);
+        str[i] = 0x7f;
+        CU_ASSERT_EQUAL(scpiLex_SpanExpression(str, sizeof (str)), i);
+
+        memset(str, '5', sizeof (str));
+        str[i] = ',';
+        CU_ASSERT_EQUAL(scpiLex_SpanData(str, sizeof (str)), i);
+        str[i] = 'Z';
+        CU_ASSERT_EQUAL(scpiLex_SpanData(str, sizeof (str)), i);
+        str[i] = '\n';
+        CU_ASSERT_EQUAL(scpiLex_SpanData(str, i + 1), i);
+        CU_ASSERT_EQUAL(scpiLex_SpanData(str, i), i);
+    }
+
+    TEST_TOKEN("'0123456789abcdef0123456789abcdef0123456789''abcdef' ", scpiLex_StringProgramData, 0, 52, SCPI_TOKEN_SINGLE_QUOTE_PROGRAM_DATA);
+    TEST_TOKEN("'0123456789abcdef0123456789abcdef\xC3" "abcdef' ", scpiLex_StringProgramData, 0, 0, SCPI_TOKEN_UNKNOWN);
+    TEST_TOKEN("(1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20) ", scpiLex_ProgramExpression, 0, 52, SCPI_TOKEN_PROGRAM_EXPRESSION);
+}
+
 static void testWhiteSpace(void) {
     TEST_TOKEN("  \t MEAS", scpiLex_WhiteSpace, 0, 4, SCPI_TOKEN_WS);
     TEST_TOKEN("MEAS", scpiLex_WhiteSpace, 0, 0, SCPI_TOKEN_UNKNOWN);
@@ -152,6 +226,57 @@ static void testDecimal(void) {
     TEST_TOKEN("1.5E12", scpiLex_DecimalNumericProgramData, 0, 6, SCPI_TOKEN_DECIMAL_NUMERIC_PROGRAM_DATA);
 }
 
+#if USE_NUMERIC_TOKEN_VALUE
+#define TEST_DECIMAL_VALUE(s, f, m, e, n, t, x) do {  \
+    char * str = s;                             \
+    lex_state_t state;                          \
+    scpi_token_t token;                         \
+                                                \
+    state.buffer = state.pos = str;             \
+    state.len = strlen(str);                    \
+    f(&state, &token);                          \
+    CU_ASSERT_EQUAL(token.decimal.mantissa, m); \
+    CU_ASSERT_EQUAL(token.decimal.exponent, e); \
+    CU_ASSERT_EQUAL(token.decimal.negative, n); \
+    CU_ASSERT_EQUAL(token.decimal.truncated, t);\
+    CU_ASSERT_EQUAL(token.decimal.suffix, x);   \
+} while(0)
+
+static void testDecimalValue(void) {
+    TEST_DECIMAL_VALUE("10", scpiLex_DecimalNumericProgramData, 10, 0, FALSE, FALSE, 2);
+    TEST_DECIMAL_VALUE("-10.5 , ", scpiLex_DecimalNumericProgramData, 105, -1, TRUE, FALSE, 5);
+    TEST_DECIMAL_VALUE("+.5", scpiLex_DecimalNumericProgramData, 5, -1, FALSE, FALSE, 3);
+    TEST_DECIMAL_VALUE("0.0025", scpiLex_DecimalNumericProgramData, 25, -4, FALSE, FALSE, 6);
+    TEST_DECIMAL_VALUE("-1 e 3, ", scpiLex_DecimalNumericProgramData, 1, 3, TRUE, FALSE, 6);
+    TEST_DECIMAL_VALUE("-1 e , ", scpiLex_DecimalNumericProgramData, 1, 0, TRUE, FALSE, 2);
+    TEST_DECIMAL_VALUE("1.5E-12", scpiLex_DecimalNumericProgramData, 15, -13, FALSE, FALSE, 7);
+    TEST_DECIMAL_VALUE("12345678901234567890", scpiLex_DecimalNumericProgramData, 1234567890123456789ull, 1, FALSE, FALSE, 20);
+    TEST_DECIMAL_VALUE("12345678901234567891", scpiLex_DecimalNumericProgramData, 1234567890123456789ull, 1, FALSE, TRUE, 20);
+    TEST_DECIMAL_VALUE("1.5E12 V", scpiParser_parseProgramData, 15, 11, FALSE, FALSE, 7);
+    TEST_DECIMAL_VALUE("100 mV", scpiParser_parseProgramData, 100, 0, FALSE, FALSE, 4);
+}
+
+#define TEST_DECIMAL_INTEGER(s, i) do {         \
+    char * str = s;                             \
+    lex_state_t state;                          \
+    scpi_token_t token;                         \
+                                                \
+    state.buffer = state.pos = str;             \
+    state.len = strlen(str);                    \
+    scpiParser_parseProgramData(&state, &token);\
+    CU_ASSERT_EQUAL(token.decimal.integer, i);  \
+} while(0)
+
+static void testDecimalInteger(void) {
+    TEST_DECIMAL_INTEGER("-10", TRUE);
+    TEST_DECIMAL_INTEGER("100 mV", TRUE);
+    TEST_DECIMAL_INTEGER("1 e , ", TRUE);
+    TEST_DECIMAL_INTEGER("10.", FALSE);
+    TEST_DECIMAL_INTEGER("1E0", FALSE);
+    TEST_DECIMAL_INTEGER("1 e -2 V", FALSE);
+}
+#endif
+
 static void testSuffix(void) {
     TEST_TOKEN("A/V , ", scpiLex_SuffixProgramData, 0, 3, SCPI_TOKEN_SUFFIX_PROGRAM_DATA);
     TEST_TOKEN("mA.h", scpiLex_SuffixProgramData, 0, 4, SCPI_TOKEN_SUFFIX_PROGRAM_DATA);
@@ -277,6 +402,7 @@ static void testAllProgramData(void) {
     TEST_ALL_TOKEN("#12\r\n, 1.5E12 V", scpiParser_parseAllProgramData, 0, 15, SCPI_TOKEN_ALL_PROGRAM_DATA, 2);
     TEST_ALL_TOKEN(" ( 1 + 2 ) ,#12\r\n, 1.5E12 V", scpiParser_parseAllProgramData, 0, 27, SCPI_TOKEN_ALL_PROGRAM_DATA, 3);
     TEST_ALL_TOKEN("\"ahoj\" , #12AB", scpiParser_parseAllProgramData, 0, 14, SCPI_TOKEN_ALL_PROGRAM_DATA, 2);
+    TEST_ALL_TOKEN("10  , 'x'", scpiParser_parseAllProgramData, 0, 9, SCPI_TOKEN_ALL_PROGRAM_DATA, 2);
 }
 
 
@@ -284,7 +410,7 @@ static void testAllProgramData(void) {
     char * str = s;                                                             \
     scpi_parser_state_t state;                                                  \
     int result;                                                                 \
-    result = scpiParser_detectProgramMessageUnit(&state, str, strlen(str));     \
+    result = scpiParser_detectProgramMessageUnit(&state, str, strlen(str), NULL, 0); \
     CU_ASSERT_EQUAL(state.programHeader.ptr, str + h);                          \
     CU_ASSERT_EQUAL(state.programHeader.len, hl);                               \
     CU_ASSERT_EQUAL(state.programHeader.type, ht);                              \
@@ -326,10 +452,16 @@ int main() {
     }
 
     /* Add the tests to the suite */
-    if ((NULL == CU_add_test(pSuite, "WhiteSpace", testWhiteSpace))
+    if ((NULL == CU_add_test(pSuite, "CharClass", testCharClass))
+            || (NULL == CU_add_test(pSuite, "Span", testSpan))
+            || (NULL == CU_add_test(pSuite, "WhiteSpace", testWhiteSpace))
             || (NULL == CU_add_test(pSuite, "Nondecimal", testNondecimal))
             || (NULL == CU_add_test(pSuite, "CharacterProgramData", testCharacterProgramData))
             || (NULL == CU_add_test(pSuite, "Decimal", testDecimal))
+#if USE_NUMERIC_TOKEN_VALUE
+            || (NULL == CU_add_test(pSuite, "DecimalValue", testDecimalValue))
+            || (NULL == CU_add_test(pSuite, "DecimalInteger", testDecimalInteger))
+#endif
             || (NULL == CU_add_test(pSuite, "Suffix", testSuffix))
             || (NULL == CU_add_test(pSuite, "ProgramHeader", testProgramHeader))
             || (NULL == CU_add_test(pSuite, "ArbitraryBlock", testArbitraryBlock))
@@ -28,6 +28,9 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <limits.h>
+#include <ctype.h>
+#include <strings.h>
 #include "CUnit/Basic.h"
 
 #include "scpi/scpi.h"
@@ -79,6 +82,57 @@ static scpi_result_t SCPI_Sample(scpi_t * context) {
     return SCPI_RES_OK;
 }
 
+#if USE_BLOCK_STREAMING
+static size_t test_stream_received = 0;
+static unsigned int test_stream_sum = 0;
+static size_t test_stream_calls = 0;
+static scpi_bool_t test_stream_fail = FALSE;
+
+static size_t test_stream_len = 0;
+
+static scpi_result_t test_streamSink(scpi_t * context, size_t total, size_t offset, const char * data, size_t len) {
+    (void) context;
+    if (test_stream_fail) return SCPI_RES_ERR;
+    if ((offset != test_stream_received) || (offset + len > total)) return SCPI_RES_ERR;
+    test_stream_received += len;
+    while (len--) {
+        test_stream_sum += (unsigned char) *data++;
+    }
+    return SCPI_RES_OK;
+}
+
+static scpi_result_t test_stream(scpi_t * context) {
+    const char * val;
+    size_t len;
+    test_stream_calls++;
+    if (!SCPI_ParamArbitraryBlock(context, &val, &len, TRUE)) return SCPI_RES_ERR;
+    /* streamed block is replaced by empty one */
+    test_stream_len = len;
+    return SCPI_RES_OK;
+}
+
+static size_t test_produce_offset = 0;
+static size_t test_produce_chunk = 0;
+
+static size_t test_produceBlock(scpi_t * context, char * buffer, size_t max) {
+    size_t i;
+    (void) context;
+    if (max > test_produce_chunk) max = test_produce_chunk;
+    for (i = 0; i < max; i++) {
+        buffer[i] = (char) ('a' + test_produce_offset++ % 26);
+    }
+    return max;
+}
+
+static scpi_result_t test_produce(scpi_t * context) {
+    uint32_t len;
+    if (!SCPI_ParamUInt32(context, &len, TRUE)) return SCPI_RES_ERR;
+    test_produce_offset = 0;
+    SCPI_ResultArbitraryBlockProducer(context, len, test_produceBlock);
+    return SCPI_RES_OK;
+}
+#endif
+
 static const scpi_command_t scpi_commands[] = {
     /* IEEE Mandated Commands (SCPI std V1999.0 4.1.1) */
     { .pattern = "*CLS", .callback = SCPI_CoreCls,},
@@ -121,12 +175,26 @@ static const scpi_command_t scpi_commands[] = {
     { .pattern = "STUB?", .callback = SCPI_StubQ,},
 
     { .pattern = "SAMple", .callback = SCPI_Sample,},
+#if USE_BLOCK_STREAMING
+    { .pattern = "TEST:STReam", .callback = test_stream, .block_sink = test_streamSink,},
+    { .pattern = "TEST:PRODuce?", .callback = test_produce,},
+#endif
     SCPI_CMD_LIST_END
 };
 
+#if USE_PRECOMPILED_COMMANDS
+/* lookup tables generated by cmdhash from preprocessed scpi_commands */
+#include "test_parser_commands.c"
+#endif
+
 
 char output_buffer[1024];
 size_t output_buffer_pos = 0;
+size_t output_write_count = 0;
+size_t output_writev_count = 0;
+size_t output_write_limit = SIZE_MAX;
+size_t output_write_stall = 0;
+size_t output_flush_count = 0;
 
 int_fast16_t err_buffer[128];
 size_t err_buffer_pos = 0;
@@ -162,12 +230,30 @@ static void error_buffer_add(int_fast16_t err) {
 static size_t SCPI_Write(scpi_t * context, const char * data, size_t len) {
     (void) context;
 
-    return output_buffer_write(data, len);
+    output_write_count++;
+    if (output_write_stall > 0) {
+        output_write_stall--;
+        return 0;
+    }
+    return output_buffer_write(data, len > output_write_limit ? output_write_limit : len);
+}
+
+static size_t SCPI_WriteVector(scpi_t * context, const scpi_iovec_t * iov, size_t iovcnt) {
+    size_t result = 0;
+    (void) context;
+
+    output_writev_count++;
+    while (iovcnt--) {
+        result += output_buffer_write(iov->data, iov->len);
+        iov++;
+    }
+    return result;
 }
 
 static scpi_result_t SCPI_Flush(scpi_t * context) {
     (void) context;
 
+    output_flush_count++;
     return SCPI_RES_OK;
 }
 
@@ -180,12 +266,14 @@ static int SCPI_Error(scpi_t * context, int_fast16_t err) {
 }
 
 scpi_reg_val_t srq_val = 0;
+int srq_count = 0;
 
 static scpi_result_t SCPI_Control(scpi_t * context, scpi_ctrl_name_t ctrl, scpi_reg_val_t val) {
     (void) context;
 
     if (SCPI_CTRL_SRQ == ctrl) {
         srq_val = val;
+        srq_count++;
     } else {
         fprintf(stderr, "**CTRL %02x: 0x%X (%d)\r\n", ctrl, val, val);
     }
@@ -218,7 +306,28 @@ static scpi_error_t scpi_error_queue_data[SCPI_ERROR_QUEUE_SIZE];
 #define SCPI_ERROR_INFO_HEAP_SIZE 16
 static char error_info_heap[SCPI_ERROR_INFO_HEAP_SIZE];
 
+#if USE_SESSION_DEFINITION
+static size_t compileCommands(scpi_command_node_t * nodes, size_t nodes_len) {
+    return SCPI_CompileCommands(&scpi_context, nodes, nodes_len);
+}
+
+static size_t compileUnits(scpi_unit_index_t * index) {
+    return SCPI_CompileUnits(&scpi_context, index);
+}
+#else
+static scpi_definition_t scpi_definition;
+
+static size_t compileCommands(scpi_command_node_t * nodes, size_t nodes_len) {
+    return SCPI_DefinitionCompileCommands(&scpi_definition, nodes, nodes_len);
+}
+
+static size_t compileUnits(scpi_unit_index_t * index) {
+    return SCPI_DefinitionCompileUnits(&scpi_definition, index);
+}
+#endif
+
 static int init_suite(void) {
+#if USE_SESSION_DEFINITION
     SCPI_Init(&scpi_context,
             scpi_commands,
             &scpi_interface,
@@ -226,6 +335,12 @@ static int init_suite(void) {
             "MA", "IN", NULL, "VER",
             scpi_input_buffer, SCPI_INPUT_BUFFER_LENGTH,
             scpi_error_queue_data, SCPI_ERROR_QUEUE_SIZE);
+#else
+    SCPI_DefinitionInit(&scpi_definition, scpi_commands, scpi_units_def, "MA", "IN", NULL, "VER");
+    SCPI_InitSession(&scpi_context, &scpi_definition, &scpi_interface,
+            scpi_input_buffer, SCPI_INPUT_BUFFER_LENGTH,
+            scpi_error_queue_data, SCPI_ERROR_QUEUE_SIZE);
+#endif
 #if USE_DEVICE_DEPENDENT_ERROR_INFORMATION && !USE_MEMORY_ALLOCATION_FREE
     SCPI_InitHeap(&scpi_context,
             error_info_heap, SCPI_ERROR_INFO_HEAP_SIZE);
@@ -296,6 +411,148 @@ static void testCommandsHandling(void) {
     error_buffer_clear();
 }
 
+static void testParameterTokenCache(void) {
+    char data[32];
+    int32_t value;
+
+    output_buffer_clear();
+    error_buffer_clear();
+
+    /* tokens remembered for the command are not used for other data */
+    strcpy(data, "STUB 1,22222\r\n");
+    SCPI_Parse(&scpi_context, data, strlen(data));
+    error_buffer_clear();
+    output_buffer_clear();
+    strcpy(data, "STUB 33333,4\r\n");
+    scpi_context.input_count = 0;
+    scpi_context.param_list.lex_state.buffer = data + 5;
+    scpi_context.param_list.lex_state.pos = data + 5;
+    scpi_context.param_list.lex_state.len = 7;
+    CU_ASSERT_TRUE(SCPI_ParamInt32(&scpi_context, &value, TRUE));
+    CU_ASSERT_EQUAL(value, 33333);
+    CU_ASSERT_TRUE(SCPI_ParamInt32(&scpi_context, &value, TRUE));
+    CU_ASSERT_EQUAL(value, 4);
+
+    CU_ASSERT_EQUAL(err_buffer_pos, 0);
+    error_buffer_clear();
+}
+
+static void testCompiledCommands(void) {
+    scpi_command_node_t nodes[64];
+
+#if USE_PRECOMPILED_COMMANDS
+    /* headers are found by tables generated by cmdhash */
+    CU_ASSERT_PTR_EQUAL(scpi_precompiled_commands.cmdlist, scpi_commands);
+    CU_ASSERT_NOT_EQUAL(scpi_precompiled_commands.size, 0);
+#endif
+
+    output_buffer_clear();
+    error_buffer_clear();
+
+    /* not enough nodes, linear search is used */
+    CU_ASSERT_EQUAL(compileCommands(nodes, 4), 0);
+    CU_ASSERT_PTR_NULL(scpi_context.definition->cmdtree);
+
+    CU_ASSERT_NOT_EQUAL(compileCommands(nodes, 64), 0);
+    CU_ASSERT_PTR_NOT_NULL(scpi_context.definition->cmdtree);
+
+    TEST_INPUT("*IDN?\r\n", "MA,IN,0,VER\r\n");
+    output_buffer_clear();
+
+#if USE_SESSION_DEFINITION
+    /* deprecated fields of the context are applied to its definition */
+    scpi_context.idn[2] = "SN";
+    TEST_INPUT("*IDN?\r\n", "MA,IN,SN,VER\r\n");
+    output_buffer_clear();
+    scpi_context.idn[2] = NULL;
+    CU_ASSERT_PTR_NOT_NULL(scpi_context.definition->cmdtree);
+#endif
+
+    TEST_INPUT("TEST:TREEA?;TREEB?\r\n", "10;20\r\n");
+    output_buffer_clear();
+
+    TEST_INPUT("TEST:TREEA?;:TEXT? \"PARAM1\", \"PARAM2\"\r\n", "10;\"PARAM2\"\r\n");
+    output_buffer_clear();
+
+    /* short and long form, optional parts */
+    TEST_INPUT("SYST:ERR?;:SYSTEM:ERROR:NEXT?;:syst:err:coun?\r\n", "0,\"No error\";0,\"No error\";0\r\n");
+    output_buffer_clear();
+
+    TEST_INPUT(":STAT:QUES?;QUES:EVEN?;:stat:oper:cond?\r\n", "0;0;0\r\n");
+    output_buffer_clear();
+
+    CU_ASSERT_EQUAL(err_buffer_pos, 0);
+    error_buffer_clear();
+
+    TEST_INPUT("SYST:ERR:NEXT:FOO?\r\n", "");
+    CU_ASSERT_EQUAL(err_buffer_pos, 1);
+    CU_ASSERT_EQUAL(err_buffer[0], SCPI_ERROR_UNDEFINED_HEADER);
+    error_buffer_clear();
+
+    TEST_INPUT("STUB?\r\n", "0\r\n");
+    output_buffer_clear();
+
+    compileCommands(NULL, 0);
+}
+
+static void testSharedDefinition(void) {
+    static scpi_command_node_t nodes[64];
+    static scpi_unit_index_t index;
+    static scpi_definition_t definition;
+    static scpi_t sessions[2];
+    static char input_buffers[2][SCPI_INPUT_BUFFER_LENGTH];
+    static scpi_error_t error_queues[2][SCPI_ERROR_QUEUE_SIZE];
+    scpi_t * session;
+    int i;
+
+    SCPI_DefinitionInit(&definition, scpi_commands, scpi_units_def, "MA", "IN", NULL, "VER");
+    CU_ASSERT_NOT_EQUAL(SCPI_DefinitionCompileCommands(&definition, nodes, 64), 0);
+    CU_ASSERT_NOT_EQUAL(SCPI_DefinitionCompileUnits(&definition, &index), 0);
+
+    for (i = 0; i < 2; i++) {
+        SCPI_InitSession(&sessions[i], &definition, &scpi_interface,
+                input_buffers[i], SCPI_INPUT_BUFFER_LENGTH,
+                error_queues[i], SCPI_ERROR_QUEUE_SIZE);
+        CU_ASSERT_PTR_EQUAL(sessions[i].definition, &definition);
+    }
+
+#if USE_SESSION_DEFINITION
+    /* shared definition is not compiled through session */
+    error_buffer_clear();
+    CU_ASSERT_EQUAL(SCPI_CompileCommands(&sessions[0], nodes, 64), 0);
+    CU_ASSERT_EQUAL(SCPI_CompileUnits(&sessions[0], &index), 0);
+    CU_ASSERT_PTR_EQUAL(definition.cmdtree, &nodes[0]);
+    CU_ASSERT_PTR_EQUAL(definition.units_index, &index);
+    CU_ASSERT_EQUAL(err_buffer_pos, 2);
+    CU_ASSERT_EQUAL(err_buffer[0], SCPI_ERROR_SYSTEM_ERROR);
+    CU_ASSERT_EQUAL(err_buffer[1], SCPI_ERROR_SYSTEM_ERROR);
+    SCPI_ErrorClear(&sessions[0]);
+    SCPI_RegSet(&sessions[0], SCPI_REG_ESR, 0);
+#endif
+
+#define TEST_SESSION(s, data, output) {                         \
+    output_buffer_clear();                                      \
+    SCPI_Input((s), data, strlen(data));                        \
+    CU_ASSERT_STRING_EQUAL(output, output_buffer);              \
+}
+    session = &sessions[0];
+    TEST_SESSION(session, "*IDN?\r\n", "MA,IN,0,VER\r\n");
+    TEST_SESSION(session, "TEST:TREEA?;TREEB?\r\n", "10;20\r\n");
+
+    /* state of sessions is independent */
+    TEST_SESSION(session, "ABCD\r\n", "");
+    TEST_SESSION(session, "*ESR?\r\n", "32\r\n");
+    session = &sessions[1];
+    TEST_SESSION(session, "SYST:ERR:COUN?\r\n", "0\r\n");
+    TEST_SESSION(session, "*ESR?\r\n", "0\r\n");
+    session = &sessions[0];
+    TEST_SESSION(session, "SYST:ERR:COUN?\r\n", "1\r\n");
+    SCPI_ErrorClear(session);
+
+    output_buffer_clear();
+    error_buffer_clear();
+}
+
 static void testErrorHandling(void) {
     output_buffer_clear();
     error_buffer_clear();
@@ -551,6 +808,19 @@ static void testSCPI_ParamInt32(void) {
     /* test range */
     TEST_ParamInt32("2147483647", TRUE, 2147483647, TRUE, 0);
     TEST_ParamInt32("-2147483647", TRUE, -2147483647, TRUE, 0);
+
+    /* results are the same as of strtol */
+    TEST_ParamInt32("1.5E3", TRUE, 1, TRUE, 0);
+    TEST_ParamInt32("-1 E 2", TRUE, -1, TRUE, 0);
+    TEST_ParamInt32("1E10", TRUE, 1, TRUE, 0);
+    TEST_ParamInt32("-1E10", TRUE, -1, TRUE, 0);
+#if LONG_MAX > 2147483647L
+    TEST_ParamInt32("3000000000", TRUE, -1294967296, TRUE, 0); /* wrapped */
+    TEST_ParamInt32("-3000000000", TRUE, 1294967296, TRUE, 0); /* wrapped */
+#else
+    TEST_ParamInt32("3000000000", TRUE, 2147483647, TRUE, 0); /* saturated */
+    TEST_ParamInt32("-3000000000", TRUE, -2147483647 - 1, TRUE, 0); /* saturated */
+#endif
 }
 
 #define TEST_ParamUInt32(data, mandatory, expected_value, expected_result, expected_error_code) \
@@ -590,6 +860,19 @@ static void testSCPI_ParamUInt32(void) {
     /* test range */
     TEST_ParamUInt32("2147483647", TRUE, 2147483647ULL, TRUE, 0);
     TEST_ParamUInt32("4294967295", TRUE, 4294967295ULL, TRUE, 0);
+
+    /* results are the same as of strtoul */
+    TEST_ParamUInt32("1.5E3", TRUE, 1, TRUE, 0);
+    TEST_ParamUInt32("-1", TRUE, 4294967295ULL, TRUE, 0); /* wrapped */
+    TEST_ParamUInt32("-1E10", TRUE, 4294967295ULL, TRUE, 0); /* wrapped */
+    TEST_ParamUInt32("-4294967295", TRUE, 1, TRUE, 0); /* wrapped */
+#if ULONG_MAX > 4294967295UL
+    TEST_ParamUInt32("4294967296", TRUE, 0, TRUE, 0); /* wrapped */
+    TEST_ParamUInt32("9999999999999999999", TRUE, 2313682943ULL, TRUE, 0); /* wrapped */
+#else
+    TEST_ParamUInt32("4294967296", TRUE, 4294967295ULL, TRUE, 0); /* saturated */
+    TEST_ParamUInt32("9999999999999999999", TRUE, 4294967295ULL, TRUE, 0); /* saturated */
+#endif
 }
 
 #define TEST_ParamInt64(data, mandatory, expected_value, expected_result, expected_error_code) \
@@ -631,6 +914,14 @@ static void testSCPI_ParamInt64(void) {
     TEST_ParamInt64("-2147483647", TRUE, -2147483647LL, TRUE, 0);
     TEST_ParamInt64("9223372036854775807", TRUE, 9223372036854775807LL, TRUE, 0);
     TEST_ParamInt64("-9223372036854775807", TRUE, -9223372036854775807LL, TRUE, 0);
+
+    /* results are the same as of strtoll */
+    TEST_ParamInt64("0.12345678901234567891E25", TRUE, 0, TRUE, 0);
+    TEST_ParamInt64("1234567890123456789.9", TRUE, 1234567890123456789LL, TRUE, 0);
+    TEST_ParamInt64("-9223372036854775808", TRUE, -9223372036854775807LL - 1, TRUE, 0);
+    TEST_ParamInt64("9999999999999999999", TRUE, 9223372036854775807LL, TRUE, 0); /* saturated */
+    TEST_ParamInt64("-9999999999999999999", TRUE, -9223372036854775807LL - 1, TRUE, 0); /* saturated */
+    TEST_ParamInt64("12345678901234567891", TRUE, 9223372036854775807LL, TRUE, 0); /* saturated */
 }
 
 #define TEST_ParamUInt64(data, mandatory, expected_value, expected_result, expected_error_code) \
@@ -672,6 +963,15 @@ static void testSCPI_ParamUInt64(void) {
     TEST_ParamUInt64("4294967295", TRUE, 4294967295ULL, TRUE, 0);
     TEST_ParamUInt64("9223372036854775807", TRUE, 9223372036854775807ULL, TRUE, 0);
     TEST_ParamUInt64("18446744073709551615", TRUE, 18446744073709551615ULL, TRUE, 0);
+
+    /* results are the same as of strtoull */
+    TEST_ParamUInt64("1.8E19", TRUE, 1, TRUE, 0);
+    TEST_ParamUInt64("12345678901234567891", TRUE, 12345678901234567891ULL, TRUE, 0);
+    TEST_ParamUInt64("1234567890123456789.12E1", TRUE, 1234567890123456789ULL, TRUE, 0);
+    TEST_ParamUInt64("9999999999999999999", TRUE, 9999999999999999999ULL, TRUE, 0);
+    TEST_ParamUInt64("-9999999999999999999", TRUE, 8446744073709551617ULL, TRUE, 0); /* wrapped */
+    TEST_ParamUInt64("-1", TRUE, 18446744073709551615ULL, TRUE, 0); /* wrapped */
+    TEST_ParamUInt64("18446744073709551616", TRUE, 18446744073709551615ULL, TRUE, 0); /* saturated */
 }
 
 
@@ -740,6 +1040,10 @@ static void testSCPI_ParamDouble(void) {
     TEST_ParamDouble("#H101010", TRUE, 1052688, TRUE, 0);
     TEST_ParamDouble("#Q10", TRUE, 8, TRUE, 0);
     TEST_ParamDouble("#HFFFFFFFF", TRUE, 0xFFFFFFFFu, TRUE, 0);
+#if USE_FAST_STRTOD
+    TEST_ParamDouble("7205759403792794.4000000000000000001 E 1", TRUE, 72057594037927952.0, TRUE, 0);
+    TEST_ParamDouble("7205759403792794.3999999999999999999 E 1", TRUE, 72057594037927936.0, TRUE, 0);
+#endif
 
     TEST_ParamDouble("", TRUE, 0, FALSE, SCPI_ERROR_MISSING_PARAMETER); /* missing parameter */
     TEST_ParamDouble("abcd", TRUE, 0, FALSE, SCPI_ERROR_DATA_TYPE_ERROR); /* Data type error */
@@ -905,6 +1209,75 @@ static void testSCPI_ParamChoice(void) {
     TEST_ParamChoice("SOUR", TRUE, 3, TRUE, 0);
 }
 
+static void testSCPI_ParamChoiceIndex(void) {
+    const scpi_choice_def_t test_options[] = {
+        {"OPTIONA", 1},
+        {"OPTIONB", 2},
+        {"SOURce", 3},
+        {"SOURce#", 4},
+        {"CHannel#", 5},
+        {"CH1", 6},
+        {"Sense", 3},
+        {"ON", 7},
+        SCPI_CHOICE_LIST_END /* termination of option list */
+    };
+    const char * inputs[] = {
+        "ON", "on", "OPTIONA", "optionb", "OPTION", "SOURCE", "sour", "SOUR2",
+        "SOURCE12", "CH1", "CHAN3", "CHANNEL", "S", "SENSE", "s", "X", "O",
+    };
+    static char long_name[300];
+    const scpi_choice_def_t long_options[] = {
+        {"ON", 7},
+        {long_name, 8},
+        SCPI_CHOICE_LIST_END /* termination of option list */
+    };
+    scpi_choice_index_t index;
+    scpi_parameter_t param;
+    int32_t value;
+    int32_t expected;
+    scpi_bool_t result;
+    const char * name;
+    size_t i;
+
+    CU_ASSERT_EQUAL(SCPI_CompileChoices(&index, test_options), SCPI_CHOICE_INDEX_MAX >= 8 ? 8 : 0);
+
+    /* compiled list selects the same option as the list */
+    for (i = 0; i < sizeof (inputs) / sizeof (inputs[0]); i++) {
+        param.type = SCPI_TOKEN_PROGRAM_MNEMONIC;
+        param.ptr = (char *) inputs[i];
+        param.len = strlen(inputs[i]);
+        expected = -1;
+        value = -1;
+        result = SCPI_ParamToChoice(&scpi_context, &param, test_options, &expected);
+        CU_ASSERT_EQUAL(SCPI_ParamToChoiceIndex(&scpi_context, &param, &index, &value), result);
+        CU_ASSERT_EQUAL(value, expected);
+    }
+    SCPI_ErrorClear(&scpi_context);
+
+    CU_ASSERT_TRUE(SCPI_ChoiceIndexToName(&index, 3, &name));
+    CU_ASSERT_STRING_EQUAL(name, "SOURce");
+    CU_ASSERT_TRUE(SCPI_ChoiceIndexToName(&index, 6, &name));
+    CU_ASSERT_STRING_EQUAL(name, "CH1");
+    CU_ASSERT_FALSE(SCPI_ChoiceIndexToName(&index, 8, &name));
+
+    /* list which does not fit is searched linearly */
+    memset(long_name, 'L', sizeof (long_name) - 1);
+    long_name[sizeof (long_name) - 1] = '\0';
+    CU_ASSERT_EQUAL(SCPI_CompileChoices(&index, long_options), 0);
+    CU_ASSERT_FALSE(index.compiled);
+    CU_ASSERT_PTR_EQUAL(index.options, long_options);
+
+    param.type = SCPI_TOKEN_PROGRAM_MNEMONIC;
+    param.ptr = (char *) "on";
+    param.len = 2;
+    value = -1;
+    CU_ASSERT_TRUE(SCPI_ParamToChoiceIndex(&scpi_context, &param, &index, &value));
+    CU_ASSERT_EQUAL(value, 7);
+    CU_ASSERT_TRUE(SCPI_ChoiceIndexToName(&index, 8, &name));
+    CU_ASSERT_PTR_EQUAL(name, long_name);
+    CU_ASSERT_FALSE(SCPI_ChoiceIndexToName(&index, 9, &name));
+}
+
 #define TEST_NumericListInt(data, index, expected_range, expected_from, expected_to, expected_result, expected_error_code) \
 {                                                                                       \
     scpi_bool_t result;                                                                 \
@@ -1103,6 +1476,60 @@ static void testParamNumber(void) {
     TEST_ParamNumber("100 xyz", TRUE, FALSE, SCPI_NUM_NUMBER, 100, SCPI_UNIT_NONE, 10, FALSE, SCPI_ERROR_INVALID_SUFFIX);
 }
 
+static void testCompileUnits(void) {
+    static scpi_unit_index_t index;
+    char data[32];
+    char buffer[32];
+    scpi_number_t value;
+    const scpi_unit_def_t * def;
+    size_t count;
+    size_t i;
+    size_t j;
+
+    for (count = 0; scpi_units_def[count].name != NULL; count++);
+    CU_ASSERT_EQUAL(compileUnits(&index), count);
+    CU_ASSERT_PTR_EQUAL(scpi_context.definition->units_index, &index);
+
+    testParamNumber();
+
+    /* suffix is found in any case, the first definition wins */
+    for (i = 0; i < count; i++) {
+        for (def = scpi_units_def; strcasecmp(def->name, scpi_units_def[i].name) != 0; def++);
+
+        sprintf(data, "2 %s", scpi_units_def[i].name);
+        for (j = 2; data[j]; j++) {
+            data[j] = (char) tolower((unsigned char) data[j]);
+        }
+        scpi_context.input_count = 0;
+        scpi_context.param_list.lex_state.buffer = data;
+        scpi_context.param_list.lex_state.len = strlen(data);
+        scpi_context.param_list.lex_state.pos = data;
+        CU_ASSERT_TRUE(SCPI_ParamNumber(&scpi_context, scpi_special_numbers_def, &value, TRUE));
+        CU_ASSERT_EQUAL(value.unit, def->unit);
+        CU_ASSERT_DOUBLE_EQUAL(value.content.value, 2 * def->mult, 2 * def->mult * 1e-12);
+    }
+
+    /* unit is formatted with the first base definition */
+    for (i = 0; i < count; i++) {
+        for (def = scpi_units_def; (def->unit != scpi_units_def[i].unit) || (def->mult != 1); def++) {
+            if (def->name == NULL) break;
+        }
+        value.special = FALSE;
+        value.base = 10;
+        value.unit = scpi_units_def[i].unit;
+        value.content.value = 1;
+        SCPI_NumberToStr(&scpi_context, scpi_special_numbers_def, &value, buffer, sizeof (buffer));
+        if (def->name == NULL) {
+            CU_ASSERT_STRING_EQUAL(buffer, "1");
+        } else {
+            CU_ASSERT_STRING_EQUAL(buffer + 2, def->name);
+        }
+    }
+
+    compileUnits(NULL);
+    CU_ASSERT_EQUAL(SCPI_ErrorCount(&scpi_context), 0);
+}
+
 #define TEST_Result(func, value, expected_result) \
 {\
     output_buffer_clear();\
@@ -1249,11 +1676,18 @@ static void testResultFloat(void) {
     TEST_Result(Float, -128, "-128");
     TEST_Result(Float, 32767, "32767");
     TEST_Result(Float, -32768, "-32768");
+#if USE_FAST_DTOA
+    TEST_Result(Float, 2147483647L, "2.1474836e+09");
+    TEST_Result(Float, -2147483647L, "-2.1474836e+09");
+    TEST_Result(Float, 9223372036854775807LL, "9.223372e+18");
+    TEST_Result(Float, -9223372036854775807LL, "-9.223372e+18");
+#else
     TEST_Result(Float, 2147483647L, "2.14748e+09");
     /* TEST_Result(Float, -2147483648, "-2.14748e+09"); bug in GCC */
     TEST_Result(Float, -2147483647L, "-2.14748e+09");
     TEST_Result(Float, 9223372036854775807LL, "9.22337e+18");
     TEST_Result(Float, -9223372036854775807LL, "-9.22337e+18");
+#endif
 
     TEST_Result(Float, 1.256e-17, "1.256e-17");
     TEST_Result(Float, -1.256e-17, "-1.256e-17");
@@ -1276,6 +1710,18 @@ static void testResultDouble(void) {
 
     TEST_Result(Double, 1.256e-17, "1.256e-17");
     TEST_Result(Double, -1.256e-17, "-1.256e-17");
+
+    SCPI_SetResultPrecision(&scpi_context, 4);
+    TEST_Result(Double, 3.14159265, "3.142");
+    TEST_Result(Double, -12345.6, "-1.235e+04");
+    TEST_Result(Float, 0.000123456f, "0.0001235");
+    TEST_Result(Double, 99.999, "100");
+    TEST_Result(Double, 24.664999999999999, "24.66");
+    TEST_Result(Double, 1.2345, "1.234");
+    SCPI_SetResultPrecision(&scpi_context, 2);
+    TEST_Result(Double, 0.125, "0.12");
+    SCPI_SetResultPrecision(&scpi_context, 0);
+    TEST_Result(Double, 3.14159265, "3.14159265");
 }
 
 static void testResultBool(void) {
@@ -1384,12 +1830,20 @@ static void testResultArray(void) {
     TEST_Result(ArrayUInt64SWAPPED, uint64_arr, "#216" "\xFB\xFF\xFF\xFF" "\xFF\xFF\xFF\xFF" "76543210");
 
     float float_arr[] = {0.7549173, 3.0196693};
+#if USE_FAST_DTOA
+    TEST_Result(ArrayFloatASCII, float_arr, "0.7549173,3.0196693");
+#else
     TEST_Result(ArrayFloatASCII, float_arr, "0.754917,3.01967");
+#endif
     TEST_Result(ArrayFloatNORMAL, float_arr, "#18" "?ABC" "@ABC");
     TEST_Result(ArrayFloatSWAPPED, float_arr, "#18" "CBA?" "CBA@");
 
     double double_arr[] = {76543217654321, 1234567891234567};
+#if USE_FAST_DTOA
+    TEST_Result(ArrayDoubleASCII, double_arr, "76543217654321,1.234567891234567e+15");
+#else
     TEST_Result(ArrayDoubleASCII, double_arr, "76543217654321,1.23456789123457e+15");
+#endif
     TEST_Result(ArrayDoubleNORMAL, double_arr, "#216" "\x42\xd1\x67\x66\xd3\x16\x8c\x40" "\x43\x11\x8b\x54\xf2\x6e\xbc\x1c");
     TEST_Result(ArrayDoubleSWAPPED, double_arr, "#216" "\x40\x8c\x16\xd3\x66\x67\xd1\x42" "\x1c\xbc\x6e\xf2\x54\x8b\x11\x43");
 }
@@ -1478,6 +1932,48 @@ static void testParamArray(void) {
     TEST_ParamArrayInt(uint64_t, SCPI_ParamArrayUInt64, "1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11", TRUE, (1, 2, 3, 4, 5, 6, 7, 8, 9, 10), TRUE, SCPI_ERROR_NO_ERROR);
 }
 
+#define TEST_ParamArrayBinary(T, func, data, format, _expected_value, expected_result, expected_error_code) \
+{                                                                                       \
+    T value[4];                                                                         \
+    scpi_bool_t result;                                                                 \
+    scpi_error_t errCode;                                                               \
+    T expected_value[] = {NOPAREN _expected_value};                                     \
+    size_t o_count;                                                                     \
+    size_t i_count = _countof(expected_value);                                          \
+                                                                                        \
+    SCPI_CoreCls(&scpi_context);                                                        \
+    scpi_context.input_count = 0;                                                       \
+    scpi_context.param_list.lex_state.buffer = data;                                    \
+    scpi_context.param_list.lex_state.len = sizeof(data) - 1;                           \
+    scpi_context.param_list.lex_state.pos = scpi_context.param_list.lex_state.buffer;   \
+    result = func(&scpi_context, value, 4, &o_count, format, TRUE);                     \
+                                                                                        \
+    SCPI_ErrorPop(&scpi_context, &errCode);                                             \
+    CU_ASSERT_EQUAL(result, expected_result);                                           \
+    if (expected_result) {                                                              \
+        CU_ASSERT_EQUAL(i_count, o_count);                                              \
+        size_t i;                                                                       \
+        for(i = 0; i < o_count; i++) {                                                  \
+            CU_ASSERT_EQUAL(value[i], expected_value[i]);                               \
+        }                                                                               \
+    }                                                                                   \
+    CU_ASSERT_EQUAL(errCode.error_code, expected_error_code);                           \
+}
+
+static void testParamArrayBinary(void) {
+    TEST_ParamArrayBinary(int32_t, SCPI_ParamArrayInt32, "#18" "\x00\x00\x00\x01" "\xFF\xFF\xFF\xFE", SCPI_FORMAT_NORMAL, (1, -2), TRUE, SCPI_ERROR_NO_ERROR);
+    TEST_ParamArrayBinary(int32_t, SCPI_ParamArrayInt32, "#18" "\x01\x00\x00\x00" "\xFE\xFF\xFF\xFF", SCPI_FORMAT_SWAPPED, (1, -2), TRUE, SCPI_ERROR_NO_ERROR);
+    TEST_ParamArrayBinary(uint32_t, SCPI_ParamArrayUInt32, "#14" "\x12\x34\x56\x78", SCPI_FORMAT_BIGENDIAN, (0x12345678), TRUE, SCPI_ERROR_NO_ERROR);
+    TEST_ParamArrayBinary(uint64_t, SCPI_ParamArrayUInt64, "#18" "\x01\x02\x03\x04\x05\x06\x07\x08", SCPI_FORMAT_LITTLEENDIAN, (0x0807060504030201ull), TRUE, SCPI_ERROR_NO_ERROR);
+    TEST_ParamArrayBinary(float, SCPI_ParamArrayFloat, "#14" "\x3F\x80\x00\x00", SCPI_FORMAT_BIGENDIAN, (1.0f), TRUE, SCPI_ERROR_NO_ERROR);
+    TEST_ParamArrayBinary(double, SCPI_ParamArrayDouble, "#18" "\x00\x00\x00\x00\x00\x00\x04\xC0", SCPI_FORMAT_LITTLEENDIAN, (-2.5), TRUE, SCPI_ERROR_NO_ERROR);
+
+    TEST_ParamArrayBinary(int32_t, SCPI_ParamArrayInt32, "#13" "\x00\x00\x01", SCPI_FORMAT_NORMAL, (0), FALSE, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+    TEST_ParamArrayBinary(int32_t, SCPI_ParamArrayInt32, "#220" "00001111222233334444", SCPI_FORMAT_NORMAL, (0), FALSE, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+    TEST_ParamArrayBinary(int32_t, SCPI_ParamArrayInt32, "1, 2", SCPI_FORMAT_NORMAL, (0), FALSE, SCPI_ERROR_DATA_TYPE_ERROR);
+    TEST_ParamArrayBinary(int32_t, SCPI_ParamArrayInt32, "", SCPI_FORMAT_NORMAL, (0), FALSE, SCPI_ERROR_MISSING_PARAMETER);
+}
+
 static void testNumberToStr(void) {
 
 #define TEST_SCPI_NumberToStr(_special, _value, _unit, expected_result) do {\
@@ -1708,6 +2204,750 @@ static void testIncompleteTextParameter(void) {
     TEST_INCOMPLETE_TEXT("AbcdEfgh", 1);
 }
 
+#define TEST_SPLIT_INPUT(_data, _part_len, _expected) do {\
+    const char command_text[] = _data;\
+    const char * command = command_text;\
+    size_t command_len = sizeof(command_text) - 1;\
+    size_t part_len = _part_len;\
+    output_buffer_clear();\
+    SCPI_ErrorClear(&scpi_context);\
+    while (command_len) {\
+        part_len = part_len > command_len ? command_len : part_len;\
+        SCPI_Input(&scpi_context, command, part_len);\
+        command += part_len;\
+        command_len -= part_len;\
+    }\
+    CU_ASSERT_EQUAL(SCPI_ErrorCount(&scpi_context), 0);\
+    CU_ASSERT_STRING_EQUAL(_expected, output_buffer);\
+} while(0)
+
+static void testSplitInput(void) {
+    size_t i;
+    const char block[8] = {'\n', ';', '\r', '"', '\'', '#', '1', '\n'};
+    char command[] = "SAMple #18[BLOCK.]\r\n";
+
+    for (i = 1; i <= 24; i++) {
+        TEST_SPLIT_INPUT("TEXT? \"\", \"a b;c\"\r\n", i, "\"a b;c\"\r\n");
+        TEST_SPLIT_INPUT("TEXT? '', 'it''s'\n", i, "\"it's\"\r\n");
+        TEST_SPLIT_INPUT("TEST:TREEA?;TREEB?\nTEST:TREEB?\r\n", i, "10;20\r\n20\r\n");
+        TEST_SPLIT_INPUT("TEXT? \"#15\", \";\"\n", i, "\";\"\r\n");
+        /* pipeline longer than the input buffer */
+        TEST_SPLIT_INPUT(
+                "TEST:TREEA?;TREEB?\nTEST:TREEA?;TREEB?\nTEST:TREEA?;TREEB?\nTEST:TREEA?;TREEB?\n"
+                "TEST:TREEA?;TREEB?\nTEST:TREEA?;TREEB?\nTEST:TREEA?;TREEB?\nTEST:TREEA?;TREEB?\n"
+                "TEST:TREEA?;TREEB?\nTEST:TREEA?;TREEB?\nTEST:TREEA?;TREEB?\nTEST:TREEA?;TREEB?\n"
+                "TEST:TREEA?;TREEB?\nTEST:TREEA?;TREEB?\nTEST:TREEA?;TREEB?\nTEST:TREEA?;TREEB?\n", i,
+                "10;20\r\n10;20\r\n10;20\r\n10;20\r\n10;20\r\n10;20\r\n10;20\r\n10;20\r\n"
+                "10;20\r\n10;20\r\n10;20\r\n10;20\r\n10;20\r\n10;20\r\n10;20\r\n10;20\r\n");
+    }
+
+    memcpy(command + 10, block, sizeof(block));
+    for (i = 1; i <= sizeof(command); i++) {
+        size_t pos;
+        size_t part_len;
+
+        memset(&test_sample_received, 0, sizeof(test_sample_received));
+        SCPI_ErrorClear(&scpi_context);
+        for (pos = 0; pos < sizeof(command) - 1; pos += part_len) {
+            part_len = sizeof(command) - 1 - pos;
+            part_len = part_len > i ? i : part_len;
+            SCPI_Input(&scpi_context, command + pos, part_len);
+        }
+        CU_ASSERT_EQUAL(SCPI_ErrorCount(&scpi_context), 0);
+        CU_ASSERT_EQUAL(memcmp(&test_sample_received, block, sizeof(block)), 0);
+    }
+
+    /* unterminated string is ended by new line, next message is answered */
+    output_buffer_clear();
+    error_buffer_clear();
+    SCPI_ErrorClear(&scpi_context);
+    SCPI_Input(&scpi_context, "TEXT? 'abc\n*IDN?\n", 17);
+    CU_ASSERT_STRING_EQUAL(output_buffer, "MA,IN,0,VER\r\n");
+    CU_ASSERT_EQUAL(err_buffer_pos, 2);
+    CU_ASSERT_EQUAL(err_buffer[0], SCPI_ERROR_INVALID_CHARACTER);
+    CU_ASSERT_EQUAL(err_buffer[1], SCPI_ERROR_UNDEFINED_HEADER);
+    output_buffer_clear();
+    error_buffer_clear();
+    SCPI_ErrorClear(&scpi_context);
+}
+
+static void testOutputBuffer(void) {
+    char buffer[32];
+    uint16_t array[40];
+    size_t i;
+
+    output_buffer_clear();
+    error_buffer_clear();
+
+    /* whole response message in one write */
+    SCPI_InitOutputBuffer(&scpi_context, buffer, sizeof (buffer));
+    output_write_count = 0;
+    TEST_INPUT("*IDN?;*IDN?\r\n", "MA,IN,0,VER;MA,IN,0,VER\r\n");
+    CU_ASSERT_EQUAL(output_write_count, 1);
+    output_buffer_clear();
+
+    /* buffer is written when full */
+    output_write_count = 0;
+    TEST_INPUT("*IDN?;*IDN?;*IDN?\r\n", "MA,IN,0,VER;MA,IN,0,VER;MA,IN,0,VER\r\n");
+    CU_ASSERT_EQUAL(output_write_count, 2);
+    output_buffer_clear();
+
+    /* long data bypass the buffer */
+    output_write_count = 0;
+    TEST_INPUT("TEXT? '', 'abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnopqrstuvwxyz0123456789'\r\n",
+            "\"abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnopqrstuvwxyz0123456789\"\r\n");
+    CU_ASSERT_EQUAL(output_write_count, 3);
+    output_buffer_clear();
+
+    /* array with swapped bytes is written through the buffer */
+    for (i = 0; i < 40; i++) {
+        array[i] = (uint16_t) (0x4100 + i);
+    }
+    scpi_context.output_count = 0;
+    output_write_count = 0;
+    CU_ASSERT_EQUAL(SCPI_ResultArrayUInt16(&scpi_context, array, 40, SCPI_FORMAT_BIGENDIAN), 84);
+    CU_ASSERT_TRUE(SCPI_OutputReady(&scpi_context));
+    CU_ASSERT_EQUAL(output_write_count, 3);
+    CU_ASSERT_EQUAL(output_buffer_pos, 84);
+    CU_ASSERT_EQUAL(memcmp(output_buffer, "#280", 4), 0);
+    for (i = 0; i < 40; i++) {
+        CU_ASSERT_EQUAL(output_buffer[4 + i * 2], 0x41);
+        CU_ASSERT_EQUAL(output_buffer[5 + i * 2], (char) i);
+    }
+    CU_ASSERT_EQUAL(scpi_context.output_count, 1);
+    output_buffer_clear();
+
+    SCPI_InitOutputBuffer(&scpi_context, NULL, 0);
+    output_write_count = 0;
+    TEST_INPUT("*IDN?\r\n", "MA,IN,0,VER\r\n");
+    CU_ASSERT_EQUAL(output_write_count, 8);
+    output_buffer_clear();
+
+    CU_ASSERT_EQUAL(err_buffer_pos, 0);
+}
+
+static void testWriteVector(void) {
+    char buffer[32];
+    const char * block = "0123456789abcdefghijklmnopqrstuvwxyz0123456789";
+    size_t len;
+
+    output_buffer_clear();
+    error_buffer_clear();
+    scpi_interface.writev = SCPI_WriteVector;
+
+    /* header and data in one call without output buffer */
+    scpi_context.output_count = 0;
+    output_write_count = 0;
+    output_writev_count = 0;
+    len = SCPI_ResultArbitraryBlock(&scpi_context, block, 10);
+    CU_ASSERT_EQUAL(len, 14);
+    CU_ASSERT_EQUAL(output_write_count, 0);
+    CU_ASSERT_EQUAL(output_writev_count, 1);
+    CU_ASSERT_EQUAL(memcmp(output_buffer, "#2100123456789", 14), 0);
+    output_buffer_clear();
+
+    /* small block is collected in output buffer */
+    SCPI_InitOutputBuffer(&scpi_context, buffer, sizeof (buffer));
+    scpi_context.output_count = 0;
+    output_write_count = 0;
+    output_writev_count = 0;
+    SCPI_ResultInt32(&scpi_context, 10);
+    len = SCPI_ResultArbitraryBlock(&scpi_context, block, 10);
+    CU_ASSERT_EQUAL(len, 15);
+    CU_ASSERT_EQUAL(output_write_count, 0);
+    CU_ASSERT_EQUAL(output_writev_count, 0);
+    CU_ASSERT_EQUAL(output_buffer_pos, 0);
+
+    /* big block goes out together with buffered data */
+    len = SCPI_ResultArbitraryBlock(&scpi_context, block, strlen(block));
+    CU_ASSERT_EQUAL(len, 51);
+    CU_ASSERT_EQUAL(output_write_count, 0);
+    CU_ASSERT_EQUAL(output_writev_count, 1);
+    CU_ASSERT_EQUAL(output_buffer_pos, 68);
+    CU_ASSERT_EQUAL(memcmp(output_buffer, "10,#2100123456789,#246", 22), 0);
+    CU_ASSERT_EQUAL(memcmp(output_buffer + 22, block, strlen(block)), 0);
+    output_buffer_clear();
+
+    /* responses are same as with write only */
+    output_write_count = 0;
+    output_writev_count = 0;
+    TEST_INPUT("*IDN?;*IDN?;*IDN?\r\n", "MA,IN,0,VER;MA,IN,0,VER;MA,IN,0,VER\r\n");
+    CU_ASSERT_EQUAL(output_write_count + output_writev_count, 2);
+    output_buffer_clear();
+
+    SCPI_InitOutputBuffer(&scpi_context, NULL, 0);
+    scpi_interface.writev = NULL;
+
+    CU_ASSERT_EQUAL(err_buffer_pos, 0);
+}
+
+static void testOutputPending(void) {
+    char buffer[32];
+    const char * text = "TEXT? '', 'abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnopqrstuvwxyz0123456789'\r\n";
+
+    output_buffer_clear();
+    error_buffer_clear();
+    SCPI_InitOutputBuffer(&scpi_context, buffer, sizeof (buffer));
+
+    /* rest of response is written when interface is ready */
+    output_write_limit = 10;
+    output_flush_count = 0;
+    SCPI_Input(&scpi_context, "*IDN?\r\n", 7);
+    CU_ASSERT_EQUAL(output_buffer_pos, 10);
+    CU_ASSERT_EQUAL(output_flush_count, 0);
+    CU_ASSERT_TRUE(SCPI_OutputPending(&scpi_context));
+    CU_ASSERT_TRUE(SCPI_OutputReady(&scpi_context));
+    CU_ASSERT_FALSE(SCPI_OutputPending(&scpi_context));
+    CU_ASSERT_EQUAL(output_flush_count, 1);
+    CU_ASSERT_STRING_EQUAL(output_buffer, "MA,IN,0,VER\r\n");
+    output_buffer_clear();
+
+    /* partially accepted big data are queued */
+    SCPI_Input(&scpi_context, text, strlen(text));
+    CU_ASSERT_TRUE(SCPI_OutputPending(&scpi_context));
+    CU_ASSERT_FALSE(SCPI_OutputReady(&scpi_context));
+    output_write_limit = SIZE_MAX;
+    CU_ASSERT_TRUE(SCPI_OutputReady(&scpi_context));
+    CU_ASSERT_STRING_EQUAL(output_buffer, "\"abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnopqrstuvwxyz0123456789\"\r\n");
+    CU_ASSERT_EQUAL(err_buffer_pos, 0);
+    output_buffer_clear();
+
+    /* full buffer waits a while until interface accepts data again */
+    output_write_stall = SCPI_OUTPUT_WRITE_RETRIES;
+    SCPI_Input(&scpi_context, text, strlen(text));
+    CU_ASSERT_EQUAL(output_write_stall, 0);
+    CU_ASSERT_TRUE(SCPI_OutputReady(&scpi_context));
+    CU_ASSERT_STRING_EQUAL(output_buffer, "\"abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnopqrstuvwxyz0123456789\"\r\n");
+    CU_ASSERT_EQUAL(err_buffer_pos, 0);
+    output_buffer_clear();
+
+    /* rest of response is discarded when interface does not accept anything */
+    output_write_count = 0;
+    output_write_stall = SIZE_MAX;
+    SCPI_Input(&scpi_context, text, strlen(text));
+    CU_ASSERT(output_write_count < 2 * (SCPI_OUTPUT_WRITE_RETRIES + 1));
+    CU_ASSERT_TRUE(SCPI_OutputPending(&scpi_context));
+    CU_ASSERT_FALSE(SCPI_OutputReady(&scpi_context));
+    output_write_stall = 0;
+    CU_ASSERT_TRUE(SCPI_OutputReady(&scpi_context));
+    CU_ASSERT_EQUAL(output_buffer_pos, sizeof (buffer));
+    CU_ASSERT_EQUAL(memcmp(output_buffer, "\"abcdefghijklmnopqrstuvwxyz0123456789", sizeof (buffer)), 0);
+    CU_ASSERT_EQUAL(err_buffer_pos, 1);
+    CU_ASSERT_EQUAL(err_buffer[0], SCPI_ERROR_QUERY_DEADLOCKED);
+    output_buffer_clear();
+    error_buffer_clear();
+
+    /* next response is not affected */
+    SCPI_Input(&scpi_context, "*IDN?\r\n", 7);
+    CU_ASSERT_STRING_EQUAL(output_buffer, "MA,IN,0,VER\r\n");
+    output_buffer_clear();
+
+    /* next message while response is not read clears output */
+    output_write_limit = 0;
+    SCPI_Input(&scpi_context, "*IDN?\r\n", 7);
+    CU_ASSERT_TRUE(SCPI_OutputPending(&scpi_context));
+    SCPI_Input(&scpi_context, "*IDN?\r\n", 7);
+    CU_ASSERT_TRUE(SCPI_OutputPending(&scpi_context));
+    output_write_limit = SIZE_MAX;
+    CU_ASSERT_TRUE(SCPI_OutputReady(&scpi_context));
+    CU_ASSERT_STRING_EQUAL(output_buffer, "MA,IN,0,VER\r\n");
+    CU_ASSERT_EQUAL(err_buffer_pos, 1);
+    CU_ASSERT_EQUAL(err_buffer[0], SCPI_ERROR_QUERY_INTERRUPTED);
+    output_buffer_clear();
+    error_buffer_clear();
+
+    SCPI_InitOutputBuffer(&scpi_context, NULL, 0);
+}
+
+static void testInputInPlace(void) {
+    char data[300];
+    size_t consumed;
+
+    /* complete messages are parsed from the application buffer */
+    output_buffer_clear();
+    SCPI_ErrorClear(&scpi_context);
+    strcpy(data, "TEST:TREEA?;TREEB?\nTEXT? 'a', 'b\n'\r\nTEST:TRE");
+    SCPI_InputInPlace(&scpi_context, data, strlen(data), &consumed);
+    CU_ASSERT_EQUAL(consumed, strlen(data));
+    CU_ASSERT_STRING_EQUAL(output_buffer, "10;20\r\n\"b\n\"\r\n");
+
+    /* incomplete message is kept in the input buffer */
+    output_buffer_clear();
+    strcpy(data, "EB?\nTEST:TREEA?\n");
+    SCPI_InputInPlace(&scpi_context, data, strlen(data), &consumed);
+    CU_ASSERT_EQUAL(consumed, strlen(data));
+    CU_ASSERT_STRING_EQUAL(output_buffer, "20\r\n10\r\n");
+
+    /* incomplete message longer than input buffer is left to application */
+    output_buffer_clear();
+    strcpy(data, "TEST:TREEA?\nTEXT? 'a', '");
+    memset(data + strlen(data), 'x', 260);
+    data[284] = 0;
+    SCPI_InputInPlace(&scpi_context, data, strlen(data), &consumed);
+    CU_ASSERT_EQUAL(consumed, 12);
+    CU_ASSERT_STRING_EQUAL(output_buffer, "10\r\n");
+
+    output_buffer_clear();
+    memmove(data, data + consumed, 272);
+    strcpy(data + 272, "'\n");
+    SCPI_InputInPlace(&scpi_context, data, strlen(data), &consumed);
+    CU_ASSERT_EQUAL(consumed, 274);
+    CU_ASSERT_STRING_EQUAL(output_buffer + strlen(output_buffer) - 5, "xx\"\r\n");
+    CU_ASSERT_EQUAL(SCPI_ErrorCount(&scpi_context), 0);
+
+    /* it is an overrun when the whole application buffer is incomplete message */
+    output_buffer_clear();
+    strcpy(data, "TEXT? 'a', '");
+    memset(data + strlen(data), 'x', 260);
+    data[272] = 0;
+    SCPI_InputInPlace(&scpi_context, data, strlen(data), &consumed);
+    CU_ASSERT_EQUAL(consumed, 272);
+    CU_ASSERT_EQUAL(SCPI_ErrorCount(&scpi_context), 1);
+    SCPI_ErrorClear(&scpi_context);
+    strcpy(data, "TEST:TREEA?\n");
+    SCPI_InputInPlace(&scpi_context, data, strlen(data), &consumed);
+    CU_ASSERT_EQUAL(consumed, 12);
+    CU_ASSERT_STRING_EQUAL(output_buffer, "10\r\n");
+    CU_ASSERT_EQUAL(SCPI_ErrorCount(&scpi_context), 0);
+
+    /* pending message is completed only by data which fit */
+    output_buffer_clear();
+    strcpy(data, "TEXT? 'a");
+    SCPI_InputInPlace(&scpi_context, data, strlen(data), &consumed);
+    CU_ASSERT_EQUAL(consumed, 8);
+    memset(data, 'x', 290);
+    data[290] = 0;
+    SCPI_InputInPlace(&scpi_context, data, strlen(data), &consumed);
+    CU_ASSERT_EQUAL(consumed, SCPI_INPUT_BUFFER_LENGTH - 1 - 8);
+    CU_ASSERT_EQUAL(SCPI_ErrorCount(&scpi_context), 0);
+
+    /* and then it is an overrun */
+    strcpy(data, "xx'\nTEST:TREEA?\n");
+    SCPI_InputInPlace(&scpi_context, data, strlen(data), &consumed);
+    CU_ASSERT_EQUAL(consumed, strlen(data));
+    CU_ASSERT_STRING_EQUAL(output_buffer, "10\r\n");
+    CU_ASSERT_EQUAL(SCPI_ErrorCount(&scpi_context), 1);
+    SCPI_ErrorClear(&scpi_context);
+}
+
+#if USE_BLOCK_STREAMING
+static void testBlockStreaming(void) {
+    char command[1100];
+    size_t command_len;
+    size_t pos;
+    size_t part_len;
+    size_t i;
+    unsigned int sum = 0;
+
+    /* block is longer than the input buffer */
+    command_len = sprintf(command, "TEST:STReam #41000");
+    for (i = 0; i < 1000; i++) {
+        command[command_len] = (char) (i * 7);
+        sum += (unsigned char) command[command_len++];
+    }
+    command_len += sprintf(command + command_len, ";TREEA?;TREEB?\r\n");
+
+    for (i = 1; i <= 128; i++) {
+        output_buffer_clear();
+        SCPI_ErrorClear(&scpi_context);
+        test_stream_received = 0;
+        test_stream_sum = 0;
+        for (pos = 0; pos < command_len; pos += part_len) {
+            part_len = command_len - pos;
+            part_len = part_len > i ? i : part_len;
+            SCPI_Input(&scpi_context, command + pos, part_len);
+        }
+        CU_ASSERT_EQUAL(SCPI_ErrorCount(&scpi_context), 0);
+        CU_ASSERT_EQUAL(test_stream_received, 1000);
+        CU_ASSERT_EQUAL(test_stream_sum, sum);
+        CU_ASSERT_EQUAL(test_stream_len, 0);
+        CU_ASSERT_STRING_EQUAL(output_buffer, "10;20\r\n");
+    }
+
+    /* block of later unit is not streamed before earlier commands are executed */
+    for (i = 1; i < 8; i++) {
+        const char * msg = "TEST:TREEA?;STReam #15abcde\r\n";
+        output_buffer_clear();
+        error_buffer_clear();
+        test_stream_received = 0;
+        test_stream_calls = 0;
+        for (pos = 0; pos < strlen(msg); pos += part_len) {
+            part_len = strlen(msg) - pos;
+            part_len = part_len > i ? i : part_len;
+            SCPI_Input(&scpi_context, msg + pos, part_len);
+        }
+        CU_ASSERT_EQUAL(test_stream_received, 0);
+        CU_ASSERT_EQUAL(test_stream_calls, 1);
+        CU_ASSERT_EQUAL(test_stream_len, 5);
+        CU_ASSERT_STRING_EQUAL(output_buffer, "10\r\n");
+        CU_ASSERT_EQUAL(err_buffer_pos, 0);
+    }
+
+    /* empty block is not streamed */
+    output_buffer_clear();
+    SCPI_ErrorClear(&scpi_context);
+    test_stream_received = 0;
+    SCPI_Input(&scpi_context, "TEST:STReam #10\r\n", 17);
+    CU_ASSERT_EQUAL(SCPI_ErrorCount(&scpi_context), 0);
+    CU_ASSERT_EQUAL(test_stream_received, 0);
+
+    /* command is not called after block_sink error */
+    output_buffer_clear();
+    error_buffer_clear();
+    test_stream_calls = 0;
+    test_stream_fail = TRUE;
+    SCPI_Input(&scpi_context, "TEST:STReam #15abcde;TREEA?;STR #10\r\n", 36);
+    test_stream_fail = FALSE;
+    CU_ASSERT_STRING_EQUAL(output_buffer, "10\r\n");
+    CU_ASSERT_EQUAL(test_stream_calls, 1);
+    CU_ASSERT_EQUAL(err_buffer_pos, 1);
+    CU_ASSERT_EQUAL(err_buffer[0], SCPI_ERROR_EXECUTION_ERROR);
+    error_buffer_clear();
+
+    /* the same in one piece and in parts */
+    for (i = 1; i < 8; i++) {
+        const char * msg = "TEST:STR #15abcde;STR #10\r\n";
+        output_buffer_clear();
+        error_buffer_clear();
+        test_stream_calls = 0;
+        test_stream_fail = TRUE;
+        for (pos = 0; pos < strlen(msg); pos += part_len) {
+            part_len = strlen(msg) - pos;
+            part_len = part_len > i ? i : part_len;
+            SCPI_Input(&scpi_context, msg + pos, part_len);
+        }
+        test_stream_fail = FALSE;
+        CU_ASSERT_EQUAL(test_stream_calls, 1);
+        CU_ASSERT_EQUAL(err_buffer_pos, 1);
+    }
+    error_buffer_clear();
+}
+
+static void testBlockProducer(void) {
+    char buffer[32];
+    char expected[200];
+    size_t expected_len;
+    size_t i;
+
+    expected_len = sprintf(expected, "#3100");
+    for (i = 0; i < 100; i++) {
+        expected[expected_len++] = (char) ('a' + i % 26);
+    }
+    expected_len += sprintf(expected + expected_len, "\r\n");
+
+    output_buffer_clear();
+    error_buffer_clear();
+    test_produce_chunk = 7;
+
+    /* without output buffer data are pulled immediately */
+    SCPI_Input(&scpi_context, "TEST:PROD? 100\r\n", 16);
+    CU_ASSERT_STRING_EQUAL(output_buffer, expected);
+    CU_ASSERT_FALSE(SCPI_OutputPending(&scpi_context));
+    output_buffer_clear();
+
+    /* data are pulled as interface accepts them */
+    SCPI_InitOutputBuffer(&scpi_context, buffer, sizeof (buffer));
+    output_write_limit = 10;
+    output_flush_count = 0;
+    SCPI_Input(&scpi_context, "TEST:PROD? 100\r\n", 16);
+    CU_ASSERT_TRUE(SCPI_OutputPending(&scpi_context));
+    for (i = 0; (i < 100) && !SCPI_OutputReady(&scpi_context); i++) {
+        CU_ASSERT_EQUAL(output_flush_count, 0);
+    }
+    CU_ASSERT_FALSE(SCPI_OutputPending(&scpi_context));
+    CU_ASSERT_EQUAL(output_flush_count, 1);
+    CU_ASSERT_STRING_EQUAL(output_buffer, expected);
+    output_write_limit = SIZE_MAX;
+    output_buffer_clear();
+
+    /* whole response is written at once when interface accepts it */
+    SCPI_Input(&scpi_context, "TEST:PROD? 100\r\n", 16);
+    CU_ASSERT_FALSE(SCPI_OutputPending(&scpi_context));
+    CU_ASSERT_STRING_EQUAL(output_buffer, expected);
+    output_buffer_clear();
+
+    /* block must be the last result, next query is rejected */
+    SCPI_Input(&scpi_context, "TEST:PROD? 100;*IDN?\r\n", 22);
+    CU_ASSERT_STRING_EQUAL(output_buffer, expected);
+    CU_ASSERT_EQUAL(err_buffer_pos, 1);
+    CU_ASSERT_EQUAL(err_buffer[0], SCPI_ERROR_QUERY_UNTERM_INDEF_RESP);
+    output_buffer_clear();
+    error_buffer_clear();
+    SCPI_InitOutputBuffer(&scpi_context, NULL, 0);
+
+    /* without output buffer data not available yet are pulled later */
+    test_produce_chunk = 0;
+    SCPI_Input(&scpi_context, "TEST:PROD? 100\r\n", 16);
+    CU_ASSERT_STRING_EQUAL(output_buffer, "#3100");
+    CU_ASSERT_TRUE(SCPI_OutputPending(&scpi_context));
+    CU_ASSERT_FALSE(SCPI_OutputReady(&scpi_context));
+    test_produce_chunk = 7;
+    CU_ASSERT_TRUE(SCPI_OutputReady(&scpi_context));
+    CU_ASSERT_STRING_EQUAL(output_buffer, expected);
+    CU_ASSERT_EQUAL(err_buffer_pos, 0);
+    output_buffer_clear();
+
+    /* the same with output buffer */
+    SCPI_InitOutputBuffer(&scpi_context, buffer, sizeof (buffer));
+    test_produce_chunk = 0;
+    SCPI_Input(&scpi_context, "TEST:PROD? 100\r\n", 16);
+    CU_ASSERT_STRING_EQUAL(output_buffer, "#3100");
+    CU_ASSERT_FALSE(SCPI_OutputReady(&scpi_context));
+    test_produce_chunk = 7;
+    CU_ASSERT_TRUE(SCPI_OutputReady(&scpi_context));
+    CU_ASSERT_STRING_EQUAL(output_buffer, expected);
+    CU_ASSERT_EQUAL(err_buffer_pos, 0);
+    output_buffer_clear();
+
+    /* response is completed when its header was sent */
+    output_write_limit = 10;
+    SCPI_Input(&scpi_context, "TEST:PROD? 100\r\n", 16);
+    CU_ASSERT_TRUE(SCPI_OutputPending(&scpi_context));
+    output_write_limit = 0;
+    SCPI_Input(&scpi_context, "*IDN?\r\n", 7);
+    output_write_limit = SIZE_MAX;
+    CU_ASSERT_TRUE(SCPI_OutputReady(&scpi_context));
+    CU_ASSERT_NSTRING_EQUAL(output_buffer, expected, expected_len);
+    CU_ASSERT_STRING_EQUAL(output_buffer + expected_len, "MA,IN,0,VER\r\n");
+    CU_ASSERT_EQUAL(err_buffer_pos, 0);
+    output_buffer_clear();
+
+    /* the same with producer which has no data yet, queries are rejected */
+    test_produce_chunk = 0;
+    SCPI_Input(&scpi_context, "TEST:PROD? 100\r\n", 16);
+    CU_ASSERT_STRING_EQUAL(output_buffer, "#3100");
+    SCPI_Input(&scpi_context, "*IDN?\r\n", 7);
+    test_produce_chunk = 7;
+    CU_ASSERT_TRUE(SCPI_OutputReady(&scpi_context));
+    CU_ASSERT_STRING_EQUAL(output_buffer, expected);
+    CU_ASSERT_EQUAL(err_buffer_pos, 1);
+    CU_ASSERT_EQUAL(err_buffer[0], SCPI_ERROR_QUERY_UNTERM_INDEF_RESP);
+    output_buffer_clear();
+    error_buffer_clear();
+
+    /* interrupted response is discarded when nothing was sent */
+    output_write_limit = 0;
+    SCPI_Input(&scpi_context, "TEST:PROD? 100\r\n", 16);
+    CU_ASSERT_TRUE(SCPI_OutputPending(&scpi_context));
+    SCPI_Input(&scpi_context, "*IDN?\r\n", 7);
+    output_write_limit = SIZE_MAX;
+    CU_ASSERT_TRUE(SCPI_OutputReady(&scpi_context));
+    CU_ASSERT_STRING_EQUAL(output_buffer, "MA,IN,0,VER\r\n");
+    CU_ASSERT_EQUAL(err_buffer_pos, 1);
+    CU_ASSERT_EQUAL(err_buffer[0], SCPI_ERROR_QUERY_INTERRUPTED);
+    output_buffer_clear();
+    error_buffer_clear();
+
+    SCPI_InitOutputBuffer(&scpi_context, NULL, 0);
+}
+#endif
+
+#if USE_REGISTER_CONDITION_SOURCE
+static scpi_reg_val_t ques_condition = 0;
+static int ques_condition_count = 0;
+
+static scpi_reg_val_t QuesCondition(scpi_t * context, scpi_reg_group_t group) {
+    (void) context;
+    (void) group;
+    ques_condition_count++;
+    return ques_condition;
+}
+
+static void testRegConditionSource(void) {
+    scpi_error_t error;
+
+    output_buffer_clear();
+    SCPI_CoreCls(&scpi_context);
+    SCPI_RegConditionSource(&scpi_context, SCPI_REG_GROUP_QUES, QuesCondition);
+
+    /* condition is sampled only on demand */
+    ques_condition_count = 0;
+    ques_condition = 0x0005;
+    CU_ASSERT_EQUAL(ques_condition_count, 0);
+    TEST_INPUT("STAT:QUES:COND?\r\n", "5\r\n");
+    CU_ASSERT_EQUAL(ques_condition_count, 1);
+    output_buffer_clear();
+
+    /* transitions are evaluated at sample time */
+    ques_condition = 0x0006;
+    TEST_INPUT("STAT:QUES?\r\n", "7\r\n");
+    output_buffer_clear();
+    TEST_INPUT("STAT:QUES?\r\n", "0\r\n");
+    output_buffer_clear();
+
+    /* status byte samples summarized groups */
+    SCPI_RegSet(&scpi_context, SCPI_REG_QUESE, 0xFFFF);
+    ques_condition = 0x0007;
+    CU_ASSERT_EQUAL(SCPI_RegGet(&scpi_context, SCPI_REG_STB) & STB_QES, STB_QES);
+    CU_ASSERT_EQUAL(SCPI_RegGet(&scpi_context, SCPI_REG_QUES), 0x0001);
+
+    /* other registers do not sample */
+    ques_condition_count = 0;
+    SCPI_RegGet(&scpi_context, SCPI_REG_QUESE);
+    SCPI_RegGet(&scpi_context, SCPI_REG_OPERC);
+    CU_ASSERT_EQUAL(ques_condition_count, 0);
+
+    /* errors and bit changes do not sample */
+    SCPI_ErrorPush(&scpi_context, SCPI_ERROR_SYNTAX);
+    SCPI_ErrorPop(&scpi_context, &error);
+    CU_ASSERT_EQUAL(error.error_code, SCPI_ERROR_SYNTAX);
+    SCPI_ErrorPop(&scpi_context, &error);
+    SCPI_RegSetBits(&scpi_context, SCPI_REG_QUESC, 0x0100);
+    SCPI_RegClearBits(&scpi_context, SCPI_REG_QUESC, 0x0100);
+    SCPI_RegSetBits(&scpi_context, SCPI_REG_STB, 0);
+    CU_ASSERT_EQUAL(ques_condition_count, 0);
+    error_buffer_clear();
+
+    SCPI_RegConditionSource(&scpi_context, SCPI_REG_GROUP_QUES, NULL);
+    SCPI_RegSet(&scpi_context, SCPI_REG_QUESC, 0);
+    SCPI_RegSet(&scpi_context, SCPI_REG_QUESE, 0);
+    SCPI_CoreCls(&scpi_context);
+}
+#endif
+
+#if USE_REGISTER_TRANSACTIONS
+static void testRegTransaction(void) {
+    SCPI_CoreCls(&scpi_context);
+    SCPI_RegSet(&scpi_context, SCPI_REG_OPERE, 0xFFFF);
+    SCPI_RegSet(&scpi_context, SCPI_REG_QUESE, 0xFFFF);
+    SCPI_RegSet(&scpi_context, SCPI_REG_SRE, STB_OPS | STB_QES);
+
+    /* changes are collected */
+    srq_count = 0;
+    SCPI_RegBegin(&scpi_context);
+    SCPI_RegSetBits(&scpi_context, SCPI_REG_OPERC, 0x0001);
+    SCPI_RegSetBits(&scpi_context, SCPI_REG_OPERC, 0x0010);
+    SCPI_RegSetBits(&scpi_context, SCPI_REG_QUESC, 0x0002);
+    SCPI_RegSetBits(&scpi_context, SCPI_REG_QUESC, 0x0004);
+    SCPI_RegClearBits(&scpi_context, SCPI_REG_QUESC, 0x0004);
+    CU_ASSERT_EQUAL(SCPI_RegGet(&scpi_context, SCPI_REG_OPERC), 0x0011);
+    CU_ASSERT_EQUAL(SCPI_RegGet(&scpi_context, SCPI_REG_OPER), 0);
+    CU_ASSERT_EQUAL(SCPI_RegGet(&scpi_context, SCPI_REG_STB), 0);
+
+    /* nested commit does nothing */
+    SCPI_RegBegin(&scpi_context);
+    SCPI_RegCommit(&scpi_context);
+    CU_ASSERT_EQUAL(SCPI_RegGet(&scpi_context, SCPI_REG_STB), 0);
+
+    /* transitions evaluated once, one service request */
+    SCPI_RegCommit(&scpi_context);
+    CU_ASSERT_EQUAL(SCPI_RegGet(&scpi_context, SCPI_REG_OPER), 0x0011);
+    CU_ASSERT_EQUAL(SCPI_RegGet(&scpi_context, SCPI_REG_QUES), 0x0002);
+    CU_ASSERT_EQUAL(SCPI_RegGet(&scpi_context, SCPI_REG_STB), STB_OPS | STB_QES | STB_SRQ);
+    CU_ASSERT_EQUAL(srq_count, 1);
+    CU_ASSERT_EQUAL(srq_val, STB_OPS | STB_QES | STB_SRQ);
+
+    /* unbalanced commit is ignored */
+    SCPI_RegCommit(&scpi_context);
+    CU_ASSERT_EQUAL(srq_count, 1);
+
+    /* value restored in transaction gives no transition */
+    SCPI_CoreCls(&scpi_context);
+    SCPI_RegBegin(&scpi_context);
+    SCPI_RegClearBits(&scpi_context, SCPI_REG_OPERC, 0x0001);
+    SCPI_RegSetBits(&scpi_context, SCPI_REG_OPERC, 0x0001);
+    SCPI_RegCommit(&scpi_context);
+    CU_ASSERT_EQUAL(SCPI_RegGet(&scpi_context, SCPI_REG_OPER), 0);
+    CU_ASSERT_EQUAL(SCPI_RegGet(&scpi_context, SCPI_REG_STB), 0);
+    CU_ASSERT_EQUAL(srq_count, 1);
+
+    SCPI_RegSet(&scpi_context, SCPI_REG_OPERC, 0);
+    SCPI_RegSet(&scpi_context, SCPI_REG_QUESC, 0);
+    SCPI_RegSet(&scpi_context, SCPI_REG_SRE, 0);
+    SCPI_RegSet(&scpi_context, SCPI_REG_OPERE, 0);
+    SCPI_RegSet(&scpi_context, SCPI_REG_QUESE, 0);
+    SCPI_CoreCls(&scpi_context);
+}
+#endif
+
+#if USE_ATOMIC_REGISTERS
+static void testRegPost(void) {
+    SCPI_RegSet(&scpi_context, SCPI_REG_OPERC, 0);
+    SCPI_RegSet(&scpi_context, SCPI_REG_QUESC, 0);
+    SCPI_CoreCls(&scpi_context);
+    SCPI_RegSet(&scpi_context, SCPI_REG_OPERE, 0xFFFF);
+    SCPI_RegSet(&scpi_context, SCPI_REG_QUESE, 0xFFFF);
+    SCPI_RegSet(&scpi_context, SCPI_REG_SRE, STB_OPS | STB_QES);
+
+    /* nothing changes before sync */
+    srq_count = 0;
+    SCPI_RegPostBits(&scpi_context, SCPI_REG_OPERC, 0x0001);
+    SCPI_RegPostBits(&scpi_context, SCPI_REG_OPERC, 0x0100);
+    SCPI_RegPostBits(&scpi_context, SCPI_REG_QUESC, 0x0002);
+    SCPI_RegPostBits(&scpi_context, SCPI_REG_QUESC, 0x0004);
+    SCPI_RegPostClearBits(&scpi_context, SCPI_REG_QUESC, 0x0004);
+    CU_ASSERT_EQUAL(SCPI_RegGet(&scpi_context, SCPI_REG_OPERC), 0);
+    CU_ASSERT_EQUAL(SCPI_RegGet(&scpi_context, SCPI_REG_STB), 0);
+
+    /* all changes are applied with one service request */
+    SCPI_RegSync(&scpi_context);
+    CU_ASSERT_EQUAL(SCPI_RegGet(&scpi_context, SCPI_REG_OPERC), 0x0101);
+    CU_ASSERT_EQUAL(SCPI_RegGet(&scpi_context, SCPI_REG_OPER), 0x0101);
+    CU_ASSERT_EQUAL(SCPI_RegGet(&scpi_context, SCPI_REG_QUESC), 0x0002);
+    /* pulse of bit 2 is not lost */
+    CU_ASSERT_EQUAL(SCPI_RegGet(&scpi_context, SCPI_REG_QUES), 0x0006);
+    CU_ASSERT_EQUAL(SCPI_RegGet(&scpi_context, SCPI_REG_STB), STB_OPS | STB_QES | STB_SRQ);
+    CU_ASSERT_EQUAL(srq_count, 1);
+    CU_ASSERT_EQUAL(srq_val, STB_OPS | STB_QES | STB_SRQ);
+
+    /* nothing posted, nothing done */
+    SCPI_RegSync(&scpi_context);
+    CU_ASSERT_EQUAL(srq_count, 1);
+
+    /* both edges of pulses are applied */
+    SCPI_RegSet(&scpi_context, SCPI_REG_QUES, 0);
+    SCPI_RegPostBits(&scpi_context, SCPI_REG_QUESC, 0x0400);
+    SCPI_RegPostClearBits(&scpi_context, SCPI_REG_QUESC, 0x0400);
+    SCPI_RegPostClearBits(&scpi_context, SCPI_REG_QUESC, 0x0002);
+    SCPI_RegPostBits(&scpi_context, SCPI_REG_QUESC, 0x0002);
+    SCPI_RegSync(&scpi_context);
+    CU_ASSERT_EQUAL(SCPI_RegGet(&scpi_context, SCPI_REG_QUESC), 0x0002);
+    CU_ASSERT_EQUAL(SCPI_RegGet(&scpi_context, SCPI_REG_QUES), 0x0402);
+    CU_ASSERT_EQUAL(srq_count, 2);
+
+    /* posted clear is applied by next command */
+    SCPI_RegPostClearBits(&scpi_context, SCPI_REG_OPERC, 0x0101);
+    output_buffer_clear();
+    TEST_INPUT("*STB?\r\n", "200\r\n");
+    output_buffer_clear();
+    CU_ASSERT_EQUAL(SCPI_RegGet(&scpi_context, SCPI_REG_OPERC), 0);
+
+    SCPI_RegSet(&scpi_context, SCPI_REG_QUESC, 0);
+    SCPI_RegSet(&scpi_context, SCPI_REG_SRE, 0);
+    SCPI_RegSet(&scpi_context, SCPI_REG_OPERE, 0);
+    SCPI_RegSet(&scpi_context, SCPI_REG_QUESE, 0);
+    SCPI_CoreCls(&scpi_context);
+}
+#endif
+
+#if USE_LOCKFREE_ERROR_QUEUE
+static void testErrorPost(void) {
+    scpi_error_t error;
+
+    output_buffer_clear();
+    error_buffer_clear();
+
+    /* posted errors change status in parser thread */
+    SCPI_ErrorPost(&scpi_context, SCPI_ERROR_INVALID_CHARACTER);
+    SCPI_ErrorPost(&scpi_context, SCPI_ERROR_SYSTEM_ERROR);
+    CU_ASSERT_EQUAL(SCPI_RegGet(&scpi_context, SCPI_REG_ESR), 0);
+    CU_ASSERT_EQUAL(err_buffer_pos, 0);
+
+    TEST_INPUT("*ESR?\r\n", "40\r\n");
+    CU_ASSERT_TRUE(SCPI_RegGet(&scpi_context, SCPI_REG_STB) & STB_QMA);
+    CU_ASSERT_EQUAL(SCPI_ErrorCount(&scpi_context), 2);
+    output_buffer_clear();
+
+    TEST_INPUT("SYST:ERR?\r\n", "-101,\"Invalid character\"\r\n");
+    output_buffer_clear();
+    CU_ASSERT_TRUE(SCPI_ErrorPop(&scpi_context, &error));
+    CU_ASSERT_EQUAL(error.error_code, SCPI_ERROR_SYSTEM_ERROR);
+    CU_ASSERT_FALSE(SCPI_RegGet(&scpi_context, SCPI_REG_STB) & STB_QMA);
+
+    error_buffer_clear();
+}
+#endif
+
 int main() {
     unsigned int result;
     CU_pSuite pSuite = NULL;
@@ -1735,13 +2975,18 @@ int main() {
             || (NULL == CU_add_test(pSuite, "SCPI_ParamArbitraryBlock", testSCPI_ParamArbitraryBlock))
             || (NULL == CU_add_test(pSuite, "SCPI_ParamBool", testSCPI_ParamBool))
             || (NULL == CU_add_test(pSuite, "SCPI_ParamChoice", testSCPI_ParamChoice))
+            || (NULL == CU_add_test(pSuite, "SCPI_ParamChoiceIndex", testSCPI_ParamChoiceIndex))
             || (NULL == CU_add_test(pSuite, "Commands handling", testCommandsHandling))
+            || (NULL == CU_add_test(pSuite, "Parameter token cache", testParameterTokenCache))
+            || (NULL == CU_add_test(pSuite, "Compiled commands", testCompiledCommands))
+            || (NULL == CU_add_test(pSuite, "Shared definition", testSharedDefinition))
             || (NULL == CU_add_test(pSuite, "Error handling", testErrorHandling))
             || (NULL == CU_add_test(pSuite, "Device dependent error handling", testErrorHandlingDeviceDependent))
             || (NULL == CU_add_test(pSuite, "IEEE 488.2 Mandatory commands", testIEEE4882))
             || (NULL == CU_add_test(pSuite, "Numeric list", testNumericList))
             || (NULL == CU_add_test(pSuite, "Channel list", testChannelList))
             || (NULL == CU_add_test(pSuite, "SCPI_ParamNumber", testParamNumber))
+            || (NULL == CU_add_test(pSuite, "SCPI_CompileUnits", testCompileUnits))
             || (NULL == CU_add_test(pSuite, "SCPI_ResultInt8", testResultInt8))
             || (NULL == CU_add_test(pSuite, "SCPI_ResultUInt8", testResultUInt8))
             || (NULL == CU_add_test(pSuite, "SCPI_ResultInt16", testResultInt16))
@@ -1758,15 +3003,61 @@ int main() {
             || (NULL == CU_add_test(pSuite, "SCPI_ResultArbitraryBlock", testResultArbitraryBlock))
             || (NULL == CU_add_test(pSuite, "SCPI_ResultArray", testResultArray))
             || (NULL == CU_add_test(pSuite, "SCPI_ParamArray", testParamArray))
+            || (NULL == CU_add_test(pSuite, "SCPI_ParamArray binary", testParamArrayBinary))
             || (NULL == CU_add_test(pSuite, "SCPI_NumberToStr", testNumberToStr))
             || (NULL == CU_add_test(pSuite, "SCPI_ErrorQueue", testErrorQueue))
             || (NULL == CU_add_test(pSuite, "Incomplete arbitrary parameter", testIncompleteArbitraryParameter))
             || (NULL == CU_add_test(pSuite, "Incomplete text parameter", testIncompleteTextParameter))
+            || (NULL == CU_add_test(pSuite, "Split input", testSplitInput))
             ) {
         CU_cleanup_registry();
         return CU_get_error();
     }
 
+    if ((NULL == CU_add_test(pSuite, "Input in place", testInputInPlace))
+            || (NULL == CU_add_test(pSuite, "Output buffer", testOutputBuffer))
+            || (NULL == CU_add_test(pSuite, "Write vector", testWriteVector))
+            || (NULL == CU_add_test(pSuite, "Output pending", testOutputPending))) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+
+#if USE_REGISTER_CONDITION_SOURCE
+    if (NULL == CU_add_test(pSuite, "Register condition source", testRegConditionSource)) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+#endif
+
+#if USE_REGISTER_TRANSACTIONS
+    if (NULL == CU_add_test(pSuite, "Register transaction", testRegTransaction)) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+#endif
+
+#if USE_ATOMIC_REGISTERS
+    if (NULL == CU_add_test(pSuite, "Register post", testRegPost)) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+#endif
+
+#if USE_LOCKFREE_ERROR_QUEUE
+    if (NULL == CU_add_test(pSuite, "Error post", testErrorPost)) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+#endif
+
+#if USE_BLOCK_STREAMING
+    if ((NULL == CU_add_test(pSuite, "Block streaming", testBlockStreaming))
+            || (NULL == CU_add_test(pSuite, "Block producer", testBlockProducer))) {
+        CU_cleanup_registry();
+        return CU_get_error();
+    }
+#endif
+
     /* Run all tests using the CUnit Basic interface */
     CU_basic_set_mode(CU_BRM_VERBOSE);
     CU_basic_run_tests();
@@ -36,6 +36,7 @@
 
 #include "scpi/scpi.h"
 #include "../src/utils_private.h"
+#include "../src/dtoa_private.h"
 
 /*
  * CUnit Test Suite
@@ -325,6 +326,65 @@ static void test_doubleToStr() {
     }
 }
 
+static void test_dtoa() {
+    char str[32];
+    size_t len;
+
+#define TEST_DTOA(func, val, precision, ref) \
+    len = func((val), str, sizeof (str), (precision)); \
+    CU_ASSERT_EQUAL(len, strlen(ref)); \
+    CU_ASSERT_STRING_EQUAL(str, ref)
+
+    /* shortest representation */
+    TEST_DTOA(dtoaDouble, 0.0, 0, "0");
+    TEST_DTOA(dtoaDouble, -0.0, 0, "-0");
+    TEST_DTOA(dtoaDouble, 1.0, 0, "1");
+    TEST_DTOA(dtoaDouble, 0.1, 0, "0.1");
+    TEST_DTOA(dtoaDouble, 0.30000000000000004, 0, "0.30000000000000004");
+    TEST_DTOA(dtoaDouble, -1234.5, 0, "-1234.5");
+    TEST_DTOA(dtoaDouble, 1e-5, 0, "1e-05");
+    TEST_DTOA(dtoaDouble, 0.0001, 0, "0.0001");
+    TEST_DTOA(dtoaDouble, 1e14, 0, "100000000000000");
+    TEST_DTOA(dtoaDouble, 1e15, 0, "1e+15");
+    TEST_DTOA(dtoaDouble, 1.2345678901234568e+17, 0, "1.2345678901234568e+17");
+    TEST_DTOA(dtoaDouble, 1.7976931348623157e308, 0, "1.7976931348623157e+308");
+    TEST_DTOA(dtoaDouble, 5e-324, 0, "5e-324");
+    TEST_DTOA(dtoaDouble, 2.2250738585072014e-308, 0, "2.2250738585072014e-308");
+    TEST_DTOA(dtoaDouble, 6.529449870502798e+16, 0, "6.529449870502798e+16");
+    TEST_DTOA(dtoaDouble, 1.479905201104594e+58, 0, "1.479905201104594e+58");
+    TEST_DTOA(dtoaDouble, 2.6229895340205037e-227, 0, "2.6229895340205037e-227");
+    TEST_DTOA(dtoaDouble, INFINITY, 0, "inf");
+    TEST_DTOA(dtoaDouble, -INFINITY, 0, "-inf");
+    TEST_DTOA(dtoaDouble, NAN, 0, "nan");
+    TEST_DTOA(dtoaFloat, 0.1f, 0, "0.1");
+    TEST_DTOA(dtoaFloat, 3.4028235e38f, 0, "3.4028235e+38");
+    TEST_DTOA(dtoaFloat, 1e-45f, 0, "1e-45");
+    TEST_DTOA(dtoaFloat, 123456.0f, 0, "123456");
+    TEST_DTOA(dtoaFloat, 1234567.0f, 0, "1.234567e+06");
+    TEST_DTOA(dtoaFloat, 1.183319e+08f, 0, "1.183319e+08");
+    TEST_DTOA(dtoaFloat, 84956576.0f, 0, "8.495658e+07");
+
+    /* significant digits */
+    TEST_DTOA(dtoaDouble, 3.14159265, 3, "3.14");
+    TEST_DTOA(dtoaDouble, 99.96, 3, "100");
+    TEST_DTOA(dtoaDouble, 123456.0, 3, "1.23e+05");
+    TEST_DTOA(dtoaDouble, 0.000123456, 2, "0.00012");
+    TEST_DTOA(dtoaDouble, 2.5, 10, "2.5");
+    TEST_DTOA(dtoaFloat, 2.71828f, 2, "2.7");
+    TEST_DTOA(dtoaDouble, 24.664999999999999, 4, "24.66");
+    TEST_DTOA(dtoaDouble, 1.2345, 4, "1.234");
+    TEST_DTOA(dtoaDouble, 0.125, 2, "0.12");
+    TEST_DTOA(dtoaDouble, 0.375, 2, "0.38");
+    TEST_DTOA(dtoaDouble, 0.1, 20, "0.10000000000000000555");
+    TEST_DTOA(dtoaDouble, 9.5, 1, "1e+01");
+    TEST_DTOA(dtoaFloat, 0.1f, 9, "0.100000001");
+
+    /* short buffer */
+    len = dtoaDouble(-12345.678, str, 5, 0);
+    CU_ASSERT_EQUAL(len, 4);
+    CU_ASSERT_STRING_EQUAL(str, "-123");
+}
+
 static void test_strBaseToInt32() {
     size_t result;
     int32_t val;
@@ -460,6 +520,75 @@ static void test_strToDouble() {
 
     TEST_STR_TO_DOUBLE("-1.2", 4, -1.2);
 
+#if USE_FAST_STRTOD
+#define TEST_STR_TO_DOUBLE_EXACT(s, r, v)               \
+    do {                                                \
+        result = strToDouble(s, &val);                  \
+        CU_ASSERT_EQUAL(result, r);                     \
+        CU_ASSERT_EQUAL(memcmp(&val, &v, sizeof(val)), 0); \
+    } while(0);                                         \
+
+    {
+        const double one = 1.0;
+        const double minus_zero = -0.0;
+        const double tenth = 0.1;
+        const double big = 1.5e300;
+        const double max = 1.7976931348623157e308;
+        const double min = 4.9406564584124654e-324;
+        const double zero = 0.0;
+        const double inf = INFINITY;
+        const double even = 9007199254740992.0;
+        const double odd = 9007199254740994.0;
+        const double kilo = 1500.0;
+        const double mantissa = 1.5;
+        const double big_even = 72057594037927936.0;
+        const double big_odd = 72057594037927952.0;
+        char long_number[850];
+
+        TEST_STR_TO_DOUBLE_EXACT("1.0", 3, one);
+        TEST_STR_TO_DOUBLE_EXACT("-0", 2, minus_zero);
+        TEST_STR_TO_DOUBLE_EXACT("0.1", 3, tenth);
+        TEST_STR_TO_DOUBLE_EXACT("1.5e300", 7, big);
+        TEST_STR_TO_DOUBLE_EXACT("1.7976931348623157e308", 22, max);
+        TEST_STR_TO_DOUBLE_EXACT("1.8e308", 7, inf);
+        TEST_STR_TO_DOUBLE_EXACT("5e-324", 6, min);
+        TEST_STR_TO_DOUBLE_EXACT("2e-324", 6, zero);
+        TEST_STR_TO_DOUBLE_EXACT("0.000000000000000000000000000001e30", 35, one);
+        TEST_STR_TO_DOUBLE_EXACT("9007199254740993", 16, even); /* tie to even */
+        TEST_STR_TO_DOUBLE_EXACT("9007199254740993.0000000000000000001", 36, odd); /* above tie */
+        TEST_STR_TO_DOUBLE_EXACT("1.5 E 3", 7, kilo); /* white space as in lexer */
+        TEST_STR_TO_DOUBLE_EXACT("1.5 E V", 3, mantissa);
+
+        /* more than 19 significant digits */
+        TEST_STR_TO_DOUBLE_EXACT("0.1000000000000000055511151231257827021181583404541015625", 57, tenth);
+        TEST_STR_TO_DOUBLE_EXACT("7205759403792794.4000000000000000000 E 1", 40, big_even);
+        TEST_STR_TO_DOUBLE_EXACT("7205759403792794.4000000000000000001 E 1", 40, big_odd);
+        TEST_STR_TO_DOUBLE_EXACT("7205759403792794.3999999999999999999 E 1", 40, big_even);
+        strcpy(long_number, "9007199254740993.");
+        memset(long_number + 17, '0', 800);
+        strcpy(long_number + 817, "1e0");
+        TEST_STR_TO_DOUBLE_EXACT(long_number, 820, odd);
+        long_number[817] = '0';
+        TEST_STR_TO_DOUBLE_EXACT(long_number, 820, even);
+    }
+
+    {
+        float fval;
+        const float ftenth = 0.1f;
+        const float fmax = 3.4028235e38f;
+
+        CU_ASSERT_EQUAL(strToFloat("0.1", &fval), 3);
+        CU_ASSERT_EQUAL(memcmp(&fval, &ftenth, sizeof(fval)), 0);
+        CU_ASSERT_EQUAL(strToFloat("3.4028235e38", &fval), 12);
+        CU_ASSERT_EQUAL(memcmp(&fval, &fmax, sizeof(fval)), 0);
+        CU_ASSERT_EQUAL(strToFloat("1.00000005960464477539", &fval), 22); /* tie to even */
+        CU_ASSERT_EQUAL(fval, 1.0f);
+        CU_ASSERT_EQUAL(strToFloat("16777216.99999999999999999999", &fval), 29);
+        CU_ASSERT_EQUAL(fval, 16777216.0f);
+        CU_ASSERT_EQUAL(strToFloat("1677721.700000000000000000001 E 1", &fval), 33);
+        CU_ASSERT_EQUAL(fval, 16777218.0f);
+    }
+#endif
 }
 
 static void test_compareStr() {
@@ -769,6 +898,42 @@ static void test_swap(void) {
     TEST_SWAP(64, 0x123456789ABCDEF0ull, 0xF0DEBC9A78563412ull);
 }
 
+static void test_swapArray(void) {
+    char src[130];
+    char dst[130];
+    size_t item_size;
+    size_t count;
+    size_t i;
+    size_t j;
+
+    for (i = 0; i < sizeof (src); i++) {
+        src[i] = (char) i;
+    }
+
+    /* unaligned arrays of different lengths to cover vector and scalar parts */
+    for (item_size = 1; item_size <= 8; item_size *= 2) {
+        for (count = 0; count * item_size <= sizeof (src) - 1; count++) {
+            scpi_bool_t ok = TRUE;
+            memset(dst, 0, sizeof (dst));
+            swapArray(dst + 1, src + 1, count, item_size);
+            for (i = 0; i < count; i++) {
+                for (j = 0; j < item_size; j++) {
+                    ok &= dst[1 + i * item_size + j] == src[1 + i * item_size + item_size - 1 - j];
+                }
+            }
+            ok &= dst[0] == 0;
+            ok &= (count * item_size + 1 >= sizeof (dst)) || (dst[count * item_size + 1] == 0);
+            CU_ASSERT(ok);
+        }
+    }
+
+    /* in place */
+    memcpy(dst, src, sizeof (dst));
+    swapArray(dst, dst, 16, 8);
+    swapArray(dst, dst, 16, 8);
+    CU_ASSERT_EQUAL(memcmp(dst, src, sizeof (dst)), 0);
+}
+
 #if USE_DEVICE_DEPENDENT_ERROR_INFORMATION && !USE_MEMORY_ALLOCATION_FREE
 
 static void test_heap(void) {
@@ -849,6 +1014,7 @@ int main() {
             || (NULL == CU_add_test(pSuite, "SCPI_dtostre", test_scpi_dtostre))
             || (NULL == CU_add_test(pSuite, "floatToStr", test_floatToStr))
             || (NULL == CU_add_test(pSuite, "doubleToStr", test_doubleToStr))
+            || (NULL == CU_add_test(pSuite, "dtoa", test_dtoa))
             || (NULL == CU_add_test(pSuite, "strBaseToInt32", test_strBaseToInt32))
             || (NULL == CU_add_test(pSuite, "strBaseToUInt32", test_strBaseToUInt32))
             || (NULL == CU_add_test(pSuite, "strBaseToInt64", test_strBaseToInt64))
@@ -860,6 +1026,7 @@ int main() {
             || (NULL == CU_add_test(pSuite, "matchCommand", test_matchCommand))
             || (NULL == CU_add_test(pSuite, "composeCompoundCommand", test_composeCompoundCommand))
             || (NULL == CU_add_test(pSuite, "swap", test_swap))
+            || (NULL == CU_add_test(pSuite, "swapArray", test_swapArray))
 #if USE_DEVICE_DEPENDENT_ERROR_INFORMATION && !USE_MEMORY_ALLOCATION_FREE
             || (NULL == CU_add_test(pSuite, "heap", test_heap))
 #endif
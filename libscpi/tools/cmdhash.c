@@ -0,0 +1,598 @@
+/*-
+ * BSD 2-Clause License
+ *
+ * Copyright (c) 2012-2018, Jan Breuer
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * @file   cmdhash.c
+ *
+ * @brief  Host tool generating precompiled command lookup tables
+ *
+ * Reads C source with scpi_command_t array (e.g. examples/common/scpi-def.c)
+ * and writes C source with minimal perfect hash over all header spellings
+ * (short/long form, with/without optional mnemonics). Generated file is
+ * linked to the application built with USE_PRECOMPILED_COMMANDS set to 1.
+ *
+ * Usage: cmdhash [-n array_name] input.c [output.c]
+ *
+ * Only the first string of each array item is used as pattern. Array items
+ * can not be conditionally compiled, because indexes in the generated table
+ * must match the compiled array. Such list can be read from preprocessed
+ * source (cc -E -P) made with the same configuration as the application.
+ * Tables must be generated again after every change of the command list.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "../src/utils_private.h"
+
+#define MAX_KEY_LENGTH 256
+#define MAX_DISPLACEMENT 0xFFFF
+
+struct _key_t {
+    char * name;
+    uint32_t h1;
+    uint32_t h2;
+    size_t * commands;
+    size_t commands_count;
+    uint32_t slot;
+};
+typedef struct _key_t key_t_;
+
+static char ** patterns;
+static size_t patterns_count;
+static key_t_ * keys;
+static size_t keys_count;
+
+static void * xrealloc(void * ptr, size_t size) {
+    void * result = realloc(ptr, size);
+    if (result == NULL) {
+        fprintf(stderr, "cmdhash: out of memory\n");
+        exit(1);
+    }
+    return result;
+}
+
+static char * readFile(const char * name) {
+    FILE * f;
+    char * data = NULL;
+    size_t len = 0;
+    size_t r;
+
+    f = fopen(name, "rb");
+    if (f == NULL) {
+        perror(name);
+        exit(1);
+    }
+
+    do {
+        data = xrealloc(data, len + 4096 + 1);
+        r = fread(data + len, 1, 4096, f);
+        len += r;
+    } while (r > 0);
+
+    data[len] = '\0';
+    fclose(f);
+    return data;
+}
+
+/**
+ * Replace comments by spaces, keep strings and line breaks
+ */
+static void stripComments(char * s) {
+    char quote = 0;
+
+    while (*s) {
+        if (quote) {
+            if (*s == '\\' && s[1]) {
+                s++;
+            } else if (*s == quote) {
+                quote = 0;
+            }
+            s++;
+        } else if (*s == '"' || *s == '\'') {
+            quote = *s++;
+        } else if (s[0] == '/' && s[1] == '*') {
+            while (*s && !(s[0] == '*' && s[1] == '/')) {
+                if (*s != '\n') *s = ' ';
+                s++;
+            }
+            if (*s) {
+                s[0] = ' ';
+                s[1] = ' ';
+                s += 2;
+            }
+        } else if (s[0] == '/' && s[1] == '/') {
+            while (*s && *s != '\n') {
+                *s++ = ' ';
+            }
+        } else {
+            s++;
+        }
+    }
+}
+
+static const char * skipSpace(const char * s) {
+    while (isspace((unsigned char) *s)) s++;
+    return s;
+}
+
+static int isIdent(char c) {
+    return isalnum((unsigned char) c) || c == '_';
+}
+
+/**
+ * Find beginning of command array initializer
+ * @return pointer after opening '{'
+ */
+static const char * findArray(const char * s, const char * name) {
+    const char * p = s;
+    const char * id;
+    size_t id_len;
+
+    while ((p = strstr(p, "scpi_command_t")) != NULL) {
+        if ((p > s && isIdent(p[-1])) || isIdent(p[14])) {
+            p++;
+            continue;
+        }
+        p = skipSpace(p + 14);
+        id = p;
+        while (isIdent(*p)) p++;
+        id_len = p - id;
+        p = skipSpace(p);
+        if (id_len == 0 || *p != '[') {
+            continue;
+        }
+        if (name != NULL && (strlen(name) != id_len || strncmp(name, id, id_len) != 0)) {
+            continue;
+        }
+        while (*p && *p != ']') p++;
+        p = skipSpace(p + 1);
+        if (*p != '=') {
+            continue;
+        }
+        p = skipSpace(p + 1);
+        if (*p != '{') {
+            continue;
+        }
+        return p + 1;
+    }
+
+    return NULL;
+}
+
+static void addPattern(char * pattern) {
+    patterns = xrealloc(patterns, (patterns_count + 1) * sizeof (*patterns));
+    patterns[patterns_count++] = pattern;
+}
+
+/**
+ * Read first string of each array item
+ */
+static void readPatterns(const char * p) {
+    int depth = 1;
+    char * pattern = NULL;
+    size_t len = 0;
+    int item_has_string = 0;
+    int bol = 0;
+
+    while (*p && depth > 0) {
+        if (*p == '\n') {
+            bol = 1;
+            p++;
+            continue;
+        }
+        if (bol && *p == '#') {
+            fprintf(stderr, "cmdhash: preprocessor directive inside of command array is not supported\n");
+            exit(1);
+        }
+        if (!isspace((unsigned char) *p)) {
+            bol = 0;
+        }
+
+        if (*p == '"') {
+            p++;
+            while (*p && *p != '"') {
+                if (*p == '\\' && p[1]) p++;
+                if (depth == 2 && !item_has_string) {
+                    pattern = xrealloc(pattern, len + 2);
+                    pattern[len++] = *p;
+                    pattern[len] = '\0';
+                }
+                p++;
+            }
+            if (*p) p++;
+            /* adjacent string literals are concatenated */
+            if (*skipSpace(p) != '"' && pattern != NULL && depth == 2) {
+                item_has_string = 1;
+            }
+            continue;
+        }
+
+        if (*p == '{') {
+            depth++;
+            if (depth == 2) {
+                pattern = NULL;
+                len = 0;
+                item_has_string = 0;
+            }
+        } else if (*p == '}') {
+            if (depth == 2) {
+                if (pattern == NULL) {
+                    /* {NULL, NULL, 0} */
+                    return;
+                }
+                addPattern(pattern);
+                pattern = NULL;
+            }
+            depth--;
+        } else if (depth == 1 && isIdent(*p)) {
+            /* SCPI_CMD_LIST_END or other macro terminates the list */
+            return;
+        }
+        p++;
+    }
+}
+
+static void addKey(const char * name, size_t command) {
+    size_t i;
+    key_t_ * key = NULL;
+
+    for (i = 0; i < keys_count; i++) {
+        if (strcmp(keys[i].name, name) == 0) {
+            key = &keys[i];
+            break;
+        }
+    }
+
+    if (key == NULL) {
+        keys = xrealloc(keys, (keys_count + 1) * sizeof (*keys));
+        key = &keys[keys_count++];
+        memset(key, 0, sizeof (*key));
+        key->name = xrealloc(NULL, strlen(name) + 1);
+        strcpy(key->name, name);
+        hashCommandHeader(name, strlen(name), &key->h1, &key->h2);
+    }
+
+    for (i = 0; i < key->commands_count; i++) {
+        if (key->commands[i] == command) {
+            return;
+        }
+    }
+
+    key->commands = xrealloc(key->commands, (key->commands_count + 1) * sizeof (*key->commands));
+    key->commands[key->commands_count++] = command;
+}
+
+/**
+ * Append mnemonic to the key in normalized form: upper case,
+ * without numeric suffix
+ */
+static size_t appendMnemonic(char * key, size_t key_len, const char * mnemonic, size_t len) {
+    size_t i;
+
+    if (key_len + len + 2 >= MAX_KEY_LENGTH) {
+        fprintf(stderr, "cmdhash: pattern too long\n");
+        exit(1);
+    }
+
+    if (key_len > 0) {
+        key[key_len++] = ':';
+    }
+
+    while (len > 0 && isdigit((unsigned char) mnemonic[len - 1])) {
+        len--;
+    }
+
+    for (i = 0; i < len; i++) {
+        key[key_len++] = toupper((unsigned char) mnemonic[i]);
+    }
+
+    return key_len;
+}
+
+/**
+ * Generate all spellings of the pattern
+ */
+static void expandPattern(const char * pattern, size_t len, int brackets, char * key, size_t key_len, int query, size_t command) {
+    size_t i;
+    size_t mnemonic_len;
+    size_t short_len;
+
+    while (len > 0) {
+        switch (pattern[0]) {
+            case ':':
+                break;
+            case '[':
+                brackets++;
+                break;
+            case ']':
+                brackets--;
+                break;
+            default:
+                for (i = 0; i < len && !strchr(":[]", pattern[i]); i++);
+                mnemonic_len = i;
+
+                if (brackets > 0) {
+                    expandPattern(pattern + i, len - i, brackets, key, key_len, query, command);
+                }
+
+                if (pattern[mnemonic_len - 1] == '#') {
+                    mnemonic_len--;
+                }
+
+                for (short_len = 0; short_len < mnemonic_len && !islower((unsigned char) pattern[short_len]); short_len++);
+
+                if (short_len != mnemonic_len) {
+                    expandPattern(pattern + i, len - i, brackets, key, appendMnemonic(key, key_len, pattern, short_len), query, command);
+                }
+                key_len = appendMnemonic(key, key_len, pattern, mnemonic_len);
+
+                pattern += i;
+                len -= i;
+                continue;
+        }
+        pattern++;
+        len--;
+    }
+
+    if (query) {
+        key[key_len++] = '?';
+    }
+    key[key_len] = '\0';
+    addKey(key, command);
+}
+
+static int compareBuckets(const void * a, const void * b) {
+    const size_t * ba = a;
+    const size_t * bb = b;
+    if (ba[1] != bb[1]) {
+        return ba[1] < bb[1] ? 1 : -1;
+    }
+    return ba[0] < bb[0] ? -1 : (ba[0] > bb[0]);
+}
+
+/**
+ * Find displacements of all buckets, so every key gets its own slot
+ * @return 1 on success
+ */
+static int buildHash(uint32_t buckets, uint16_t * displacements) {
+    size_t (*order)[2];
+    unsigned char * used;
+    uint32_t * slots;
+    size_t i, j, k, n;
+    uint32_t d;
+
+    order = xrealloc(NULL, buckets * sizeof (*order));
+    used = xrealloc(NULL, keys_count);
+    slots = xrealloc(NULL, keys_count * sizeof (*slots));
+    memset(used, 0, keys_count);
+
+    for (i = 0; i < buckets; i++) {
+        order[i][0] = i;
+        order[i][1] = 0;
+        displacements[i] = 0;
+    }
+    for (i = 0; i < keys_count; i++) {
+        order[keys[i].h1 % buckets][1]++;
+    }
+    qsort(order, buckets, sizeof (*order), compareBuckets);
+
+    for (i = 0; i < buckets && order[i][1] > 0; i++) {
+        for (d = 0; d <= MAX_DISPLACEMENT; d++) {
+            n = 0;
+            for (j = 0; j < keys_count; j++) {
+                if (keys[j].h1 % buckets != order[i][0]) {
+                    continue;
+                }
+                slots[n] = hashCommandSlot(keys[j].h2, d, keys_count);
+                if (used[slots[n]]) {
+                    break;
+                }
+                for (k = 0; k < n; k++) {
+                    if (slots[k] == slots[n]) {
+                        break;
+                    }
+                }
+                if (k < n) {
+                    break;
+                }
+                n++;
+            }
+            if (j == keys_count) {
+                break;
+            }
+        }
+
+        if (d > MAX_DISPLACEMENT) {
+            free(order);
+            free(used);
+            free(slots);
+            return 0;
+        }
+
+        displacements[order[i][0]] = d;
+        for (j = 0; j < keys_count; j++) {
+            if (keys[j].h1 % buckets == order[i][0]) {
+                keys[j].slot = hashCommandSlot(keys[j].h2, d, keys_count);
+                used[keys[j].slot] = 1;
+            }
+        }
+    }
+
+    free(order);
+    free(used);
+    free(slots);
+    return 1;
+}
+
+static int compareSizes(const void * a, const void * b) {
+    const size_t * sa = a;
+    const size_t * sb = b;
+    return *sa < *sb ? -1 : (*sa > *sb);
+}
+
+static void writeTable(FILE * f, const char * name, const uint16_t * data, size_t len) {
+    size_t i;
+
+    fprintf(f, "static const uint16_t %s[%lu] = {", name, (unsigned long) len);
+    for (i = 0; i < len; i++) {
+        fprintf(f, "%s%u,", (i % 12) ? " " : "\n    ", data[i]);
+    }
+    fprintf(f, "\n};\n\n");
+}
+
+int main(int argc, char ** argv) {
+    const char * array_name = NULL;
+    const char * input;
+    const char * output = NULL;
+    const char * array;
+    char * source;
+    char key[MAX_KEY_LENGTH];
+    size_t i, j, n, len;
+    uint32_t buckets;
+    uint16_t * displacements;
+    uint16_t * slots;
+    uint16_t * commands;
+    FILE * f = stdout;
+    int argi = 1;
+
+    if (argc > 2 && strcmp(argv[1], "-n") == 0) {
+        array_name = argv[2];
+        argi = 3;
+    }
+    if (argi >= argc) {
+        fprintf(stderr, "Usage: %s [-n array_name] input.c [output.c]\n", argv[0]);
+        return 1;
+    }
+    input = argv[argi++];
+    if (argi < argc) {
+        output = argv[argi];
+    }
+
+    source = readFile(input);
+    stripComments(source);
+    array = findArray(source, array_name);
+    if (array == NULL) {
+        fprintf(stderr, "cmdhash: scpi_command_t array not found in %s\n", input);
+        return 1;
+    }
+    if (array_name == NULL) {
+        /* take name from the source */
+        const char * p = array - 1;
+        const char * end;
+        while (*p != '[') p--;
+        while (p > source && isspace((unsigned char) p[-1])) p--;
+        end = p;
+        while (p > source && isIdent(p[-1])) p--;
+        array_name = xrealloc(NULL, end - p + 1);
+        memcpy((char *) array_name, p, end - p);
+        ((char *) array_name)[end - p] = '\0';
+    }
+
+    readPatterns(array);
+    if (patterns_count == 0 || patterns_count >= 0xFFFF) {
+        fprintf(stderr, "cmdhash: unsupported number of commands %lu\n", (unsigned long) patterns_count);
+        return 1;
+    }
+
+    for (i = 0; i < patterns_count; i++) {
+        len = strlen(patterns[i]);
+        if (len == 0) {
+            continue;
+        }
+        if (patterns[i][len - 1] == '?') {
+            expandPattern(patterns[i], len - 1, 0, key, 0, 1, i);
+        } else {
+            expandPattern(patterns[i], len, 0, key, 0, 0, i);
+        }
+    }
+
+    if (keys_count >= 0xFFFF) {
+        fprintf(stderr, "cmdhash: too many header spellings %lu\n", (unsigned long) keys_count);
+        return 1;
+    }
+
+    displacements = xrealloc(NULL, keys_count * sizeof (*displacements));
+    for (buckets = keys_count / 4 + 1; buckets <= keys_count; buckets *= 2) {
+        if (buildHash(buckets, displacements)) {
+            break;
+        }
+    }
+    if (buckets > keys_count && !buildHash(keys_count, displacements)) {
+        fprintf(stderr, "cmdhash: perfect hash not found\n");
+        return 1;
+    }
+    if (buckets > keys_count) {
+        buckets = keys_count;
+    }
+
+    /* slot table points to the list of candidate commands */
+    slots = xrealloc(NULL, (keys_count + 1) * sizeof (*slots));
+    commands = NULL;
+    n = 0;
+    for (i = 0; i < keys_count; i++) {
+        for (j = 0; j < keys_count; j++) {
+            if (keys[j].slot == i) {
+                break;
+            }
+        }
+        slots[i] = n;
+        qsort(keys[j].commands, keys[j].commands_count, sizeof (size_t), compareSizes);
+        commands = xrealloc(commands, (n + keys[j].commands_count) * sizeof (*commands));
+        for (len = 0; len < keys[j].commands_count; len++) {
+            commands[n++] = keys[j].commands[len];
+        }
+    }
+    slots[keys_count] = n;
+
+    if (output != NULL) {
+        f = fopen(output, "w");
+        if (f == NULL) {
+            perror(output);
+            return 1;
+        }
+    }
+
+    fprintf(f, "/*\n * Generated by cmdhash from %s, do not edit.\n", input);
+    fprintf(f, " * %lu commands, %lu header spellings\n */\n\n", (unsigned long) patterns_count, (unsigned long) keys_count);
+    fprintf(f, "#include \"scpi/scpi.h\"\n\n");
+    fprintf(f, "extern const scpi_command_t %s[];\n\n", array_name);
+    writeTable(f, "displacements", displacements, buckets);
+    writeTable(f, "slots", slots, keys_count + 1);
+    writeTable(f, "commands", commands, n);
+    fprintf(f, "const scpi_precompiled_commands_t scpi_precompiled_commands = {\n");
+    fprintf(f, "    %s, %lu, %lu, displacements, slots, commands\n};\n", array_name, (unsigned long) keys_count, (unsigned long) buckets);
+
+    if (f != stdout) {
+        fclose(f);
+    }
+
+    return 0;
+}